@@ -439,7 +439,7 @@ bool bluetooth_init (bluetooth_settings_t *settings)
     xSemaphoreGive(tx_busy);
 
     if(polltask == NULL) {
-        if(xTaskCreatePinnedToCore(pollTX, "btTX", 4096, NULL, 2, &polltask, 1) == pdPASS)
+        if(xTaskCreatePinnedToCore(pollTX, "btTX", 4096, NULL, 2, &polltask, BT_TASK_CORE) == pdPASS)
             vTaskSuspend(polltask);
         else
             return false;
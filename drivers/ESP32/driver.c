@@ -153,11 +153,32 @@ typedef struct {
 static io_stream_t prev_stream = {0};
 #endif
 
+#if WIFI_ENABLE
+
+#ifndef SECONDARY_REPORT_INTERVAL
+#define SECONDARY_REPORT_INTERVAL 200 // ms, min. time between realtime reports to outputs other than the active stream
+#endif
+
+static network_services_t services = {0};
+
+static const stream_output_t serial_output = {
+    .type = StreamType_Serial,
+    .write = serialWriteS,
+    .report_interval = SECONDARY_REPORT_INTERVAL,
+    .drop_policy = FanoutDrop_Reports
+};
+
+#endif
+
 const io_stream_t serial_stream = {
     .type = StreamType_Serial,
     .read = serialRead,
     .write = serialWriteS,
+#if WIFI_ENABLE
+    .write_all = stream_fanout_write_all,
+#else
     .write_all = serialWriteS,
+#endif
     .get_rx_buffer_available = serialRXFree,
     .reset_read_buffer = serialFlush,
     .cancel_read_buffer = serialCancel,
@@ -167,27 +188,44 @@ const io_stream_t serial_stream = {
 
 #if WIFI_ENABLE
 
-static network_services_t services = {0};
-
-void tcpStreamWriteS (const char *data)
-{
 #if TELNET_ENABLE
-    if(services.telnet)
-        TCPStreamWriteS(data);
+static bool telnetIsConnected (void)
+{
+    return services.telnet;
+}
+
+static const stream_output_t telnet_output = {
+    .type = StreamType_Telnet,
+    .write = TCPStreamWriteS,
+    .get_tx_buffer_free = TCPStreamTxFree,
+    .is_connected = telnetIsConnected,
+    .report_interval = SECONDARY_REPORT_INTERVAL,
+    .drop_policy = FanoutDrop_All
+};
 #endif
+
 #if WEBSOCKET_ENABLE
-    if(services.websocket)
-        WsStreamWriteS(data);
-#endif
-    serialWriteS(data);
+static bool websocketIsConnected (void)
+{
+    return services.websocket;
 }
 
+static const stream_output_t websocket_output = {
+    .type = StreamType_WebSocket,
+    .write = WsStreamWriteS,
+    .get_tx_buffer_free = WsStreamTxFree,
+    .is_connected = websocketIsConnected,
+    .report_interval = SECONDARY_REPORT_INTERVAL,
+    .drop_policy = FanoutDrop_All
+};
+#endif
+
 #if TELNET_ENABLE
 const io_stream_t telnet_stream = {
     .type = StreamType_Telnet,
     .read = TCPStreamGetC,
     .write = TCPStreamWriteS,
-    .write_all = tcpStreamWriteS,
+    .write_all = stream_fanout_write_all,
     .get_rx_buffer_available = TCPStreamRxFree,
     .reset_read_buffer = TCPStreamRxFlush,
     .cancel_read_buffer = TCPStreamRxCancel,
@@ -201,7 +239,7 @@ const io_stream_t websocket_stream = {
     .type = StreamType_WebSocket,
     .read = WsStreamGetC,
     .write = WsStreamWriteS,
-    .write_all = tcpStreamWriteS,
+    .write_all = stream_fanout_write_all,
     .get_rx_buffer_available = WsStreamRxFree,
     .reset_read_buffer = WsStreamRxFlush,
     .cancel_read_buffer = WsStreamRxCancel,
@@ -1645,6 +1683,16 @@ bool driver_init (void)
 
     hal.system_control_get_state = systemGetState;
 
+#if WIFI_ENABLE
+    stream_fanout_register(&serial_output);
+  #if TELNET_ENABLE
+    stream_fanout_register(&telnet_output);
+  #endif
+  #if WEBSOCKET_ENABLE
+    stream_fanout_register(&websocket_output);
+  #endif
+#endif
+
     selectStream(StreamType_Serial);
 
 #if EEPROM_ENABLE
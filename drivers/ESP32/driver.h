@@ -173,6 +173,28 @@ static const DRAM_ATTR float FZERO = 0.0f;
 #define TRINAMIC_I2C     0
 #endif
 
+#ifndef DUAL_CORE_ENABLE
+#define DUAL_CORE_ENABLE 0
+#endif
+
+// Task placement. When dual core is enabled the Grbl task (protocol parsing, planning and segment prep)
+// runs alone on core 1 at a priority above idle, stream I/O, webui and DNS tasks are pinned to core 0.
+// Data is exchanged via the single producer, single consumer stream buffers (rxbuf/txbuf) only.
+// When disabled task placement is as before: Grbl and Bluetooth TX on core 1, other tasks not pinned.
+// NOTE: lwIP (tcpip thread) core affinity is set by CONFIG_TCPIP_TASK_AFFINITY in sdkconfig, the shipped
+//       sdkconfig leaves it unpinned. When enabling dual core set it to core 0 with idf.py menuconfig:
+//       Component config > LWIP > TCP/IP task affinity > CPU0.
+#define GRBL_TASK_CORE 1
+#if DUAL_CORE_ENABLE
+#define GRBL_TASK_PRIORITY  1
+#define COMMS_TASK_CORE     0
+#define BT_TASK_CORE        COMMS_TASK_CORE
+#else
+#define GRBL_TASK_PRIORITY  0
+#define COMMS_TASK_CORE     tskNO_AFFINITY
+#define BT_TASK_CORE        1
+#endif
+
 // end configuration
 
 #if !WIFI_ENABLE
@@ -37,6 +37,8 @@
 
 #include "grbl/grbllib.h"
 
+#include "driver.h"
+
 #include "nvs.h"
 #include "nvs_flash.h"
 
@@ -45,6 +47,10 @@
 #include "freertos/task.h"
 #include "sdkconfig.h"
 
+#if DUAL_CORE_ENABLE
+#include "esp_task_wdt.h"
+#endif
+
 static void vGrblTask (void *pvParameters)
 {
     grbl_enter();
@@ -58,5 +64,10 @@ void app_main(void)
             ret = nvs_flash_init();
     }
 
-    xTaskCreatePinnedToCore(vGrblTask, "Grbl", 4096, NULL, 0, NULL, 1);
+#if DUAL_CORE_ENABLE
+    // The Grbl task never blocks and will starve the idle task on its core, stop the watchdog from monitoring it.
+    esp_task_wdt_delete(xTaskGetIdleTaskHandleForCPU(GRBL_TASK_CORE));
+#endif
+
+    xTaskCreatePinnedToCore(vGrblTask, "Grbl", 4096, NULL, GRBL_TASK_PRIORITY, NULL, GRBL_TASK_CORE);
 }
@@ -879,6 +879,7 @@ bool httpdaemon_start (network_settings_t *network)
     config.server_port = network->http_port;
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.stack_size = 10240;
+    config.core_id = COMMS_TASK_CORE; // webui JSON generation and file system reads run on the communications core
 
     httpdaemon_stop();
 
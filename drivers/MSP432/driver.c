@@ -27,6 +27,12 @@
 #include "driver.h"
 #include "serial.h"
 #include "grbl/pid.h"
+#ifdef PID_LOG
+#include "grbl/pid_log.h"
+#endif
+#ifdef ENABLE_SPINDLE_SYNC
+#include "grbl/spindle_sync.h"
+#endif
 
 #ifdef USE_I2C
 #include "i2c.h"
@@ -78,21 +84,6 @@ typedef struct {
     bool pid_enabled;
 } spindle_control_t;
 
-typedef struct {
-    float block_start;              // Spindle position at start of move (number of revolutions)
-    float prev_pos;                 // Target position of previous segment
-    float steps_per_mm;             // Steps per mm for current block
-    float programmed_rate;          // Programmed feed in mm/rev for current block
-    uint32_t min_cycles_per_tick;   // Minimum cycles per tick for PID loop
-    void (*stepper_pulse_start_normal)(stepper_t *stepper);
-    uint_fast8_t segment_id;        // Used for detecing start of new segment
-    pidf_t pid;                     // PID data for position
-#ifdef PID_LOG
-    int32_t log[PID_LOG];
-    int32_t pos[PID_LOG];
-#endif
-} spindle_sync_t;
-
 static volatile bool spindleLock = false;
 static bool IOInitDone = false;
 // Inverts the probe pin state depending on user settings and probing cycle mode.
@@ -102,7 +93,9 @@ static volatile uint32_t elapsed_tics = 0;
 static axes_signals_t next_step_outbits;
 static spindle_data_t spindle_data;
 static spindle_encoder_t spindle_encoder = {0};
-static spindle_sync_t spindle_tracker;
+#ifdef ENABLE_SPINDLE_SYNC
+static volatile uint32_t encoder_pulse_count = 0; // Free running encoder pulse count, extended to 32 bits
+#endif
 static delay_t delay = { .ms = 1, .callback = NULL }; // NOTE: initial ms set to 1 for "resetting" systick timer on startup
 
 #ifdef DRIVER_SETTINGS
@@ -159,7 +152,6 @@ static modbus_stream_t modbus_stream = {0};
 
 #endif
 
-static void stepperPulseStartSynchronized (stepper_t *stepper);
 static void spindleDataReset (void);
 static spindle_data_t spindleGetData (spindle_data_request_t request);
 
@@ -242,7 +234,6 @@ static void stepperWakeUp (void)
     stepperEnable((axes_signals_t){AXES_BITMASK});
     STEPPER_TIMER->LOAD = 0x000FFFFFUL;
     STEPPER_TIMER->CONTROL |= TIMER32_CONTROL_ENABLE|TIMER32_CONTROL_IE;
-    spindle_tracker.segment_id = 0;
 }
 
 // Disables stepper driver interrupts
@@ -263,18 +254,10 @@ static void stepperCyclesPerTick (uint32_t cycles_per_tick)
 }
 
 // "Normal" version: Sets stepper direction and pulse pins and starts a step pulse a few nanoseconds later.
-// If spindle synchronized motion switch to PID version.
 static void stepperPulseStart (stepper_t *stepper)
 {
     if(stepper->new_block) {
 
-        if(stepper->exec_segment->spindle_sync) {
-            spindle_tracker.stepper_pulse_start_normal = hal.stepper_pulse_start;
-            hal.stepper_pulse_start = stepperPulseStartSynchronized;
-            hal.stepper_pulse_start(stepper);
-            return;
-        }
-
         stepper->new_block = false;
 
         if(stepper->dir_change)
@@ -288,18 +271,10 @@ static void stepperPulseStart (stepper_t *stepper)
 }
 
 // Delayed pulse version: sets stepper direction and pulse pins and starts a step pulse with an initial delay.
-// If spindle synchronized motion switch to PID version.
 static void stepperPulseStartDelayed (stepper_t *stepper)
 {
     if(stepper->new_block) {
 
-        if(stepper->exec_segment->spindle_sync) {
-            spindle_tracker.stepper_pulse_start_normal = hal.stepper_pulse_start;
-            hal.stepper_pulse_start = stepperPulseStartSynchronized;
-            hal.stepper_pulse_start(stepper);
-            return;
-        }
-
         stepper->new_block = false;
 
         if(stepper->dir_change) {
@@ -324,95 +299,6 @@ static void stepperPulseStartDelayed (stepper_t *stepper)
     }
 }
 
-// Spindle sync version: sets stepper direction and pulse pins and starts a step pulse.
-// Switches back to "normal" version if spindle synchronized motion is finished.
-// TODO: add delayed pulse handling...
-static void stepperPulseStartSynchronized (stepper_t *stepper)
-{
-    static bool sync = false;
-
-    if(stepper->new_block) {
-        if(!stepper->exec_segment->spindle_sync) {
-            hal.stepper_pulse_start = spindle_tracker.stepper_pulse_start_normal;
-            hal.stepper_pulse_start(stepper);
-            return;
-        }
-        sync = true;
-        set_dir_outputs(stepper->dir_outbits);
-        spindle_tracker.programmed_rate = stepper->exec_block->programmed_rate;
-        spindle_tracker.steps_per_mm = stepper->exec_block->steps_per_mm;
-        spindle_tracker.segment_id = 0;
-        spindle_tracker.prev_pos = 0.0f;
-        spindle_tracker.block_start = spindleGetData(SpindleData_AngularPosition).angular_position * spindle_tracker.programmed_rate;
-        pidf_reset(&spindle_tracker.pid);
-#ifdef PID_LOG
-        sys.pid_log.idx = 0;
-        sys.pid_log.setpoint = 100.0f;
-#endif
-    }
-
-    if(stepper->step_outbits.value) {
-        set_step_outputs(stepper->step_outbits);
-        PULSE_TIMER->CTL |= TIMER_A_CTL_CLR|TIMER_A_CTL_MC1;
-    }
-
-    if(spindle_tracker.segment_id != stepper->exec_segment->id) {
-
-        spindle_tracker.segment_id = stepper->exec_segment->id;
-
-        if(stepper->new_block)
-            stepper->new_block = false;
-
-        else {  // adjust this segments total time for any positional error since last segment
-
-            float actual_pos;
-
-            if(stepper->exec_segment->cruising) {
-
-                float dt = (float)hal.f_step_timer / (float)(stepper->exec_segment->cycles_per_tick * stepper->exec_segment->n_step);
-                actual_pos = spindleGetData(SpindleData_AngularPosition).angular_position * spindle_tracker.programmed_rate;
-
-                if(sync) {
-                    spindle_tracker.pid.sample_rate_prev = dt;
-//                    spindle_tracker.block_start += (actual_pos - spindle_tracker.block_start) - spindle_tracker.prev_pos;
-//                    spindle_tracker.block_start += spindle_tracker.prev_pos;
-                    sync = false;
-                }
-
-                actual_pos -= spindle_tracker.block_start;
-                int32_t step_delta = (int32_t)(pidf(&spindle_tracker.pid, spindle_tracker.prev_pos, actual_pos, dt) * spindle_tracker.steps_per_mm);
-
-
-                int32_t ticks = (((int32_t)stepper->step_count + step_delta) * (int32_t)stepper->exec_segment->cycles_per_tick) / (int32_t)stepper->step_count;
-
-                stepper->exec_segment->cycles_per_tick = (uint32_t)max(ticks, (int32_t)spindle_tracker.min_cycles_per_tick);
-
-                stepperCyclesPerTick(stepper->exec_segment->cycles_per_tick);
-           } else
-               actual_pos = spindle_tracker.prev_pos;
-
-#ifdef PID_LOG
-            if(sys.pid_log.idx < PID_LOG) {
-
-                sys.pid_log.target[sys.pid_log.idx] = spindle_tracker.prev_pos;
-                sys.pid_log.actual[sys.pid_log.idx] = actual_pos; // - spindle_tracker.prev_pos;
-
-                spindle_tracker.log[sys.pid_log.idx] = STEPPER_TIMER->BGLOAD << stepper->amass_level;
-            //    spindle_tracker.pos[sys.pid_log.idx] = stepper->exec_segment->cycles_per_tick  stepper->amass_level;
-                spindle_tracker.pos[sys.pid_log.idx] = stepper->exec_segment->cycles_per_tick * stepper->step_count;
-                STEPPER_TIMER->BGLOAD = STEPPER_TIMER->LOAD;
-
-             //   spindle_tracker.pos[sys.pid_log.idx] = spindle_tracker.prev_pos;
-
-                sys.pid_log.idx++;
-            }
-#endif
-        }
-
-        spindle_tracker.prev_pos = stepper->exec_segment->target_position;
-    }
-}
-
 // Enable/disable limit pins interrupt
 static void limitsEnable (bool on, bool homing)
 {
@@ -681,6 +567,9 @@ static void spindleSetStateVariable (spindle_state_t state, float rpm)
         spindle_control.pid_state = PIDState_Disabled;
         pidf_reset(&spindle_control.pid);
         spindle_control.pid.sample_rate_prev = 1.0f;
+  #ifdef sPID_LOG
+        pid_log_stop();
+  #endif
 #endif
     } else {
         spindle_dir(state.ccw);
@@ -693,7 +582,7 @@ static void spindleSetStateVariable (spindle_state_t state, float rpm)
             }
         }
   #ifdef sPID_LOG
-        sys.pid_log.idx = 0;
+        pid_log_start(2, 0.0f, 0);
   #endif
         spindle_set_speed(spindle_compute_pwm_value(&spindle_pwm, rpm + spindle_control.pid.error, spindle_control.pid.error != 0.0f));
 #else
@@ -737,11 +626,7 @@ inline static void spindle_rpm_pid (uint32_t tpp)
     float error = pidf(&spindle_control.pid, spindle_data.rpm_programmed, spindle_encoder.rpm, 1.0);
 
 #ifdef sPID_LOG
-    if(sys.pid_log.idx < PID_LOG) {
-        sys.pid_log.target[sys.pid_log.idx] = error;
-        sys.pid_log.actual[sys.pid_log.idx] = rpm;
-        sys.pid_log.idx++;
-    }
+    pid_log_sample(2, (float[]){ error, spindle_encoder.rpm });
 #endif
 
     SPINDLE_PWM_TIMER->CCR[2] = spindle_compute_pwm_value(&spindle_pwm, spindle_data.rpm_programmed + error, error != 0.0f);
@@ -753,6 +638,29 @@ inline static void spindle_rpm_pid (uint32_t tpp)
 
 #endif // VFD_SPINDLE
 
+#ifdef ENABLE_SPINDLE_SYNC
+
+// RPM timer is counting down, the spindle sync module expects a timer counting up.
+static uint32_t rpmTimerGetTimestamp (void)
+{
+    return ~RPM_TIMER->VALUE;
+}
+
+static spindle_data_t spindleGetData (spindle_data_request_t request)
+{
+    spindle_sync_get_data(&spindle_data, request);
+
+#ifdef SPINDLE_RPM_CONTROLLED
+    // Use filtered RPM from the PID loop when running.
+    if(request == SpindleData_RPM && spindle_control.pid_enabled && spindle_data.rpm > 0.0f)
+        spindle_data.rpm = spindle_encoder.rpm;
+#endif
+
+    return spindle_data;
+}
+
+#else
+
 static spindle_data_t spindleGetData (spindle_data_request_t request)
 {
     bool stopped;
@@ -791,6 +699,8 @@ static spindle_data_t spindleGetData (spindle_data_request_t request)
     return spindle_data;
 }
 
+#endif // ENABLE_SPINDLE_SYNC
+
 static void spindleDataReset (void)
 {
     while(spindleLock);
@@ -820,6 +730,10 @@ static void spindleDataReset (void)
     RPM_COUNTER->CCR[0] = spindle_encoder.pulse_counter_trigger;
     RPM_COUNTER->CTL = TIMER_A_CTL_MC__CONTINUOUS|TIMER_A_CTL_CLR;
 
+#ifdef ENABLE_SPINDLE_SYNC
+    spindle_sync_reset_data(&spindle_data);
+#endif
+
     if(systick_state & SysTick_CTRL_ENABLE_Msk)
         SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
 }
@@ -964,10 +878,7 @@ void settings_changed (settings_t *settings)
     hal.driver_cap.spindle_at_speed = hal.driver_cap.variable_spindle && settings->spindle.ppr > 0;
     hal.spindle_set_state = hal.driver_cap.variable_spindle ? spindleSetStateVariable : spindleSetState;
 
-    if((hal.spindle_get_data = hal.driver_cap.spindle_at_speed ? spindleGetData : NULL)) {
-        pidf_init(&spindle_tracker.pid, &settings->position.pid);
-        spindle_tracker.min_cycles_per_tick = hal.f_step_timer / 1000000UL * (settings->steppers.pulse_microseconds * 2 + settings->steppers.pulse_delay_microseconds);
-    }
+    hal.spindle_get_data = hal.driver_cap.spindle_at_speed ? spindleGetData : NULL;
 
   #if SPINDLE_RPM_CONTROLLED
 
@@ -1002,6 +913,15 @@ void settings_changed (settings_t *settings)
     if(!hal.spindle_get_data)
         BITBAND_PERI(RPM_INDEX_PORT->IE, RPM_INDEX_PIN) = 0;
 
+#ifdef ENABLE_SPINDLE_SYNC
+    // Spindle synchronized motion is handled by the core, the RPM timer prescaler is 16.
+    spindle_sync_init(&(spindle_encoder_cfg_t){
+        .ppr = hal.spindle_get_data ? settings->spindle.ppr : 0,
+        .f_timer = SystemCoreClock / 16,
+        .get_timestamp = rpmTimerGetTimestamp
+    });
+#endif
+
 #if STEP_OUTMODE == GPIO_MAP
     for(idx = 0; idx < sizeof(step_outmap); idx++)
         step_outmap[idx] = c_step_outmap[idx ^ settings->steppers.step_invert.mask];
@@ -1275,7 +1195,6 @@ static bool driver_setup (settings_t *settings)
     NVIC_EnableIRQ(RPM_INDEX_INT);
 
     memset(&spindle_encoder, 0, sizeof(spindle_encoder_t));
-    memset(&spindle_tracker, 0, sizeof(spindle_sync_t));
     memset(&spindle_data, 0, sizeof(spindle_data));
 
     spindle_encoder.pulse_counter_trigger = 4;
@@ -1591,7 +1510,9 @@ bool driver_init (void)
 
   // driver capabilities, used for announcing and negotiating (with Grbl) driver functionality
 
+#ifdef ENABLE_SPINDLE_SYNC
     hal.driver_cap.spindle_sync = On;
+#endif
 #ifndef VFD_SPINDLE
     hal.driver_cap.spindle_at_speed = On;
     hal.driver_cap.spindle_dir = On;
@@ -1708,6 +1629,10 @@ void RPMCOUNTER_IRQHandler (void)
     RPM_COUNTER->CCTL[0] &= ~TIMER_A_CCTLN_CCIFG;
 
     spindle_data.pulse_count += cval - spindle_encoder.pulse_counter_last;
+#ifdef ENABLE_SPINDLE_SYNC
+    encoder_pulse_count += (uint16_t)(cval - spindle_encoder.pulse_counter_last);
+    spindle_encoder_capture(encoder_pulse_count, ~tval);
+#endif
     spindle_encoder.pulse_counter_last = cval;
     spindle_encoder.tpp = (spindle_encoder.timer_value_last - tval) >> 2; // spindle_encoder.pulse_counter_trigger..
     spindle_encoder.timer_value_last = tval;
@@ -1729,6 +1654,9 @@ void CONTROL_IRQHandler (void)
             RPM_COUNTER->CCR[0] = RPM_COUNTER->R + spindle_encoder.pulse_counter_trigger;
         spindle_encoder.pulse_counter_index = RPM_COUNTER->R;
         spindle_data.index_count++;
+#ifdef ENABLE_SPINDLE_SYNC
+        spindle_encoder_index(encoder_pulse_count + (uint16_t)(spindle_encoder.pulse_counter_index - spindle_encoder.pulse_counter_last));
+#endif
 //        hal.spindle_index_callback(&spindle_data);
     }
 
@@ -1813,6 +1741,9 @@ void CONTROL_FH_CS_IRQHandler (void)
             RPM_COUNTER->CCR[0] = RPM_COUNTER->R + spindle_encoder.pulse_counter_trigger;
         spindle_encoder.pulse_counter_index = RPM_COUNTER->R;
         spindle_data.index_count++;
+#ifdef ENABLE_SPINDLE_SYNC
+        spindle_encoder_index(encoder_pulse_count + (uint16_t)(spindle_encoder.pulse_counter_index - spindle_encoder.pulse_counter_last));
+#endif
 //        hal.spindle_index_callback(&spindle_data);
     }
 
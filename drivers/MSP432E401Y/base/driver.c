@@ -29,6 +29,9 @@
 #include "driver.h"
 #include "eeprom.h"
 #include "serial.h"
+#ifdef PID_LOG
+#include "grbl/pid_log.h"
+#endif
 
 #include "grbl/protocol.h"
 
@@ -86,27 +89,63 @@ static uint16_t step_prescaler[3] = {
 
 #if ETHERNET_ENABLE
 
+#ifndef SECONDARY_REPORT_INTERVAL
+#define SECONDARY_REPORT_INTERVAL 200 // ms, min. time between realtime reports to outputs other than the active stream
+#endif
+
 static network_services_t services = {0};
 
-static void enetStreamWriteS (const char *data)
+static uint16_t serialTxFree (void)
 {
-#if TELNET_ENABLE
-    if(services.telnet)
-        TCPStreamWriteS(data);
-#endif
-#if WEBSOCKET_ENABLE
-    if(services.websocket)
-        WsStreamWriteS(data);
-#endif
-    serialWriteS(data);
+    return (TX_BUFFER_SIZE - 1) - serialTxCount();
 }
 
+static const stream_output_t serial_output = {
+    .type = StreamType_Serial,
+    .write = serialWriteS,
+    .get_tx_buffer_free = serialTxFree,
+    .report_interval = SECONDARY_REPORT_INTERVAL,
+    .drop_policy = FanoutDrop_Reports
+};
+
+  #if TELNET_ENABLE
+    static bool telnetIsConnected (void)
+    {
+        return services.telnet;
+    }
+
+    static const stream_output_t telnet_output = {
+        .type = StreamType_Telnet,
+        .write = TCPStreamWriteS,
+        .get_tx_buffer_free = TCPStreamTxFree,
+        .is_connected = telnetIsConnected,
+        .report_interval = SECONDARY_REPORT_INTERVAL,
+        .drop_policy = FanoutDrop_All
+    };
+  #endif
+
+  #if WEBSOCKET_ENABLE
+    static bool websocketIsConnected (void)
+    {
+        return services.websocket;
+    }
+
+    static const stream_output_t websocket_output = {
+        .type = StreamType_WebSocket,
+        .write = WsStreamWriteS,
+        .get_tx_buffer_free = WsStreamTxFree,
+        .is_connected = websocketIsConnected,
+        .report_interval = SECONDARY_REPORT_INTERVAL,
+        .drop_policy = FanoutDrop_All
+    };
+  #endif
+
   #if TELNET_ENABLE
     const io_stream_t ethernet_stream = {
         .type = StreamType_Telnet,
         .read = TCPStreamGetC,
         .write = TCPStreamWriteS,
-        .write_all = enetStreamWriteS,
+        .write_all = stream_fanout_write_all,
         .get_rx_buffer_available = TCPStreamRxFree,
         .reset_read_buffer = TCPStreamRxFlush,
         .cancel_read_buffer = TCPStreamRxCancel,
@@ -124,7 +163,7 @@ static void enetStreamWriteS (const char *data)
         .type = StreamType_WebSocket,
         .read = WsStreamGetC,
         .write = WsStreamWriteS,
-        .write_all = enetStreamWriteS,
+        .write_all = stream_fanout_write_all,
         .get_rx_buffer_available = WsStreamRxFree,
         .reset_read_buffer = WsStreamRxFlush,
         .cancel_read_buffer = WsStreamRxCancel,
@@ -144,7 +183,7 @@ const io_stream_t serial_stream = {
     .read = serialGetC,
     .write = serialWriteS,
 #if ETHERNET_ENABLE
-    .write_all = enetStreamWriteS,
+    .write_all = stream_fanout_write_all,
 #else
     .write_all = serialWriteS,
 #endif
@@ -686,6 +725,9 @@ static void stepperPulseStartSyncronized (stepper_t *stepper)
             spindle_sync.timer_value_start = 123;
             spindle_sync.block_start = 2.33f;
             spindle_sync.segments = 0;
+#ifdef PID_LOG
+            pid_log_start(1, 0.0f, 0);
+#endif
             spindle_sync.segment_id = stepper->exec_segment->id + 1; // force recalc
         }
         set_dir_outputs(stepper->dir_outbits);
@@ -704,7 +746,9 @@ static void stepperPulseStartSyncronized (stepper_t *stepper)
 
         float epulses = dist * spindle_sync.dpp;
 
-        sys.pid_log.target[spindle_sync.segments] = stepper->exec_segment->target_position;
+#ifdef PID_LOG
+        pid_log_sample(1, &stepper->exec_segment->target_position);
+#endif
 
         spindle_sync.segments++;
 
@@ -1784,6 +1828,16 @@ bool driver_init (void)
 
     hal.system_control_get_state = systemGetState;
 
+#if ETHERNET_ENABLE
+    stream_fanout_register(&serial_output);
+  #if TELNET_ENABLE
+    stream_fanout_register(&telnet_output);
+  #endif
+  #if WEBSOCKET_ENABLE
+    stream_fanout_register(&websocket_output);
+  #endif
+#endif
+
     selectStream(StreamType_Serial);
 
     hal.nvs.type = NVS_EEPROM;
@@ -51,6 +51,8 @@ typedef struct {
 #define SPI_RX GPIO_PQ3_SSI3XDAT1
 
 void SPI__DriverInit (SPI_driver_t *drv);
+TMC2130_status_t SPI_ReadRegisters (TMC2130_t *driver, TMC2130_datagram_t **regs, uint_fast8_t n);
+TMC2130_status_t SPI_PollRegister (TMC2130_t *driver, TMC2130_datagram_t *reg);
 
 #endif
 
@@ -58,6 +58,7 @@ int usage(const char* badarg)
       "    -b <block file>    : file to report each block executed.  default = stdout\n"
       "    -s <step file>     : file to report each step executed.  default = stderr\n"
       "    -e <EEPROM file>   : file containing grblHAL settings.  default = EEPROM.DAT\n"
+      "    -l <PID log file>  : file to write PID log captures to as CSV.  default = none\n"
       "    -p <port>          : port to open raw telnet communication.\n"
       "    -c<comment_char>   : character to print before each line from grbl.  default = '#'\n"
       "    -n                 : no comments before grbl response lines.\n"
@@ -214,6 +215,16 @@ int main(int argc, char *argv[])
                     args.step_time = atof(*argv);
                     break;
 
+                case 'l': //PID log file
+                    argv++; argc--;
+                    args.pid_log_file = fopen(*argv,"w");
+                    if (!args.pid_log_file) {
+                        perror("fopen");
+                        printf("Error opening : %s\n",*argv);
+                        return(usage(0));
+                    }
+                    break;
+
                 case 'p':  // Raw telnet port
                     argv++; argc--;
                     args.port = atoi(*argv);
@@ -338,6 +349,8 @@ int main(int argc, char *argv[])
     fclose(args.block_out_file);
     fclose(args.step_out_file);
     fclose(args.serial_out_file);
+    if(args.pid_log_file)
+        fclose(args.pid_log_file);
 
     if(args.port) {
         if(sim.socket_fd)
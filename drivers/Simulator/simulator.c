@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "simulator.h"
@@ -120,6 +121,77 @@ void sim_loop (void)
     }
 }
 
+static uint8_t base64_value (char c)
+{
+    if(c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if(c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if(c >= '0' && c <= '9')
+        return c - '0' + 52;
+
+    return c == '+' ? 62 : (c == '/' ? 63 : 0xFF);
+}
+
+// Decode streamed PID log capture lines from grbl output and write them to args.pid_log_file,
+// one sample per row: sample index followed by the channel values.
+static void sim_pid_log_out (uint8_t data)
+{
+    static char line[512];
+    static uint16_t len = 0;
+    static unsigned int n_channels = 0;
+
+    if(data != '\n' && data != '\r') {
+        if(len < sizeof(line) - 1)
+            line[len++] = data;
+        return;
+    }
+
+    line[len] = '\0';
+    len = 0;
+
+    if(strncmp(line, "[PIDLOG:", 8))
+        return;
+
+    char *s = &line[8];
+
+    if(!strncmp(s, "START,", 6)) {
+        float t_sample;
+        unsigned int decimation;
+        if(sscanf(s + 6, "%f,%u,%u]", &t_sample, &n_channels, &decimation) == 3)
+            fprintf(args.pid_log_file, "# sample time %f, channels %u, decimation %u\n", t_sample, n_channels, decimation);
+    } else if(!strncmp(s, "END,", 4))
+        fprintf(args.pid_log_file, "# end %s\n", s + 4);
+    else if(n_channels) {
+
+        uint8_t bytes[384], value;
+        uint32_t acc = 0, bits = 0, n_bytes = 0, idx = strtoul(s, &s, 10), channel = 0;
+        float sample;
+
+        if(*s++ != '|')
+            return;
+
+        while((value = base64_value(*s++)) != 0xFF && n_bytes < sizeof(bytes)) {
+            acc = (acc << 6) | value;
+            if((bits += 6) >= 8) {
+                bits -= 8;
+                bytes[n_bytes++] = (uint8_t)(acc >> bits);
+            }
+        }
+
+        for(uint32_t i = 0; i + sizeof(float) <= n_bytes; i += sizeof(float)) {
+            memcpy(&sample, &bytes[i], sizeof(float));
+            if(channel == 0)
+                fprintf(args.pid_log_file, "%u", idx++);
+            fprintf(args.pid_log_file, ",%f", sample);
+            if(++channel == n_channels) {
+                fprintf(args.pid_log_file, "\n");
+                channel = 0;
+            }
+        }
+    }
+}
+
 // Print serial output to args.serial_out_file
 void sim_serial_out (uint8_t data)
 {
@@ -127,6 +199,9 @@ void sim_serial_out (uint8_t data)
     static uint8_t len = 0;
     static bool continuation = 0;
 
+    if(args.pid_log_file)
+        sim_pid_log_out(data);
+
     buf[len++] = data;
     // print when we get to newline or run out of buffer
     if(data == '\n' || data == '\r' || len >= 127) {
@@ -147,6 +222,9 @@ void sim_socket_out (uint8_t data)
     static uint8_t len = 0;
     static bool continuation = 0;
 
+    if(args.pid_log_file)
+        sim_pid_log_out(data);
+
     buf[len++] = data;
     // print when we get to newline or run out of buffer
     if(data == '\n' || data == '\r' || len >= 127) {
@@ -54,6 +54,7 @@ typedef struct arg_vars {
     FILE *block_out_file;
     FILE *step_out_file;
     FILE *serial_out_file;
+    FILE *pid_log_file;     // CSV file for decoded PID log captures, optional
     char eeprom_file[128];
     double step_time;       // Minimum time step for printing stepper values. Given by user via command line
     uint8_t comment_char;   // Char to prefix comments; default  '#' 
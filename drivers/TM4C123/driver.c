@@ -28,6 +28,9 @@
 #include "driver.h"
 #include "eeprom.h"
 #include "serial.h"
+#ifdef PID_LOG
+#include "grbl/pid_log.h"
+#endif
 
 #if KEYPAD_ENABLE
 #include "keypad/keypad.h"
@@ -346,6 +349,9 @@ static void stepperPulseStartSyncronized (stepper_t *stepper)
             spindle_sync.timer_value_start = 123;
             spindle_sync.block_start = 2.33f;
             spindle_sync.segments = 0;
+#ifdef PID_LOG
+            pid_log_start(1, 0.0f, 0);
+#endif
             spindle_sync.segment_id = stepper->exec_segment->id + 1; // force recalc
         }
         set_dir_outputs(stepper->dir_outbits);
@@ -364,7 +370,9 @@ static void stepperPulseStartSyncronized (stepper_t *stepper)
 
         float epulses = dist * spindle_sync.dpp;
 
-        sys.pid_log.target[spindle_sync.segments] = stepper->exec_segment->target_position;
+#ifdef PID_LOG
+        pid_log_sample(1, &stepper->exec_segment->target_position);
+#endif
 
         spindle_sync.segments++;
 
@@ -30,39 +30,20 @@
 #define F_SPI 4000000
 #define SPI_DELAY _delay_cycles(5)
 
-static TMC2130_status_t SPI_ReadRegister (TMC2130_t *driver, TMC2130_datagram_t *reg)
+// Transfer a datagram, returns status and the payload of the register addressed by the previous datagram.
+static TMC2130_status_t spi_transfer (chip_select_t *cs, uint8_t addr, uint32_t *payload)
 {
     uint32_t data;
     TMC2130_status_t status;
 
-    chip_select_t *cs = (chip_select_t *)driver->cs_pin;
-
-    GPIOPinWrite(cs->port, cs->pin, 0);
-
-    SPI_DELAY;
-
-    // dummy write to prepare data
-    SSIDataPut(SPI_BASE, reg->addr.value);
-    SSIDataPut(SPI_BASE, 0);
-    SSIDataPut(SPI_BASE, 0);
-    SSIDataPut(SPI_BASE, 0);
-    SSIDataPut(SPI_BASE, 0);
-    while(SSIBusy(SPI_BASE));
-
-    // Ditch data in FIFO
+    // Ditch any data left in FIFO by writes
     while(SSIDataGetNonBlocking(SPI_BASE, &data));
 
-    GPIOPinWrite(cs->port, cs->pin, cs->pin);
-
-    SPI_DELAY;
-
-    // get register data
-
     GPIOPinWrite(cs->port, cs->pin, 0);
 
     SPI_DELAY;
 
-    SSIDataPut(SPI_BASE, reg->addr.value);
+    SSIDataPut(SPI_BASE, addr);
     SSIDataPut(SPI_BASE, 0);
     SSIDataPut(SPI_BASE, 0);
     SSIDataPut(SPI_BASE, 0);
@@ -73,19 +54,55 @@ static TMC2130_status_t SPI_ReadRegister (TMC2130_t *driver, TMC2130_datagram_t
     SSIDataGetNonBlocking(SPI_BASE, &data);
     status.value = (uint8_t)data;
     SSIDataGetNonBlocking(SPI_BASE, &data);
-    reg->payload.value = ((uint8_t)data << 24);
+    *payload = ((uint8_t)data << 24);
     SSIDataGetNonBlocking(SPI_BASE, &data);
-    reg->payload.value |= ((uint8_t)data << 16);
+    *payload |= ((uint8_t)data << 16);
     SSIDataGetNonBlocking(SPI_BASE, &data);
-    reg->payload.value |= ((uint8_t)data << 8);
+    *payload |= ((uint8_t)data << 8);
     SSIDataGetNonBlocking(SPI_BASE, &data);
-    reg->payload.value |= (uint8_t)data;
+    *payload |= (uint8_t)data;
 
     GPIOPinWrite(cs->port, cs->pin, cs->pin);
 
+    SPI_DELAY;
+
     return status;
 }
 
+// Read a set of registers from a driver.
+// The TMC2130 returns the data for the register addressed by the previous datagram, reads are pipelined
+// so that n registers are read in n + 1 transfers instead of 2n.
+TMC2130_status_t SPI_ReadRegisters (TMC2130_t *driver, TMC2130_datagram_t **regs, uint_fast8_t n)
+{
+    uint32_t dummy;
+    uint_fast8_t idx;
+    TMC2130_status_t status = {0};
+    chip_select_t *cs = (chip_select_t *)driver->cs_pin;
+
+    if(n) {
+
+        spi_transfer(cs, regs[0]->addr.value, &dummy);
+
+        for(idx = 1; idx <= n; idx++)
+            status = spi_transfer(cs, regs[idx == n ? n - 1 : idx]->addr.value, &regs[idx - 1]->payload.value);
+    }
+
+    return status;
+}
+
+// Read a register with a single transfer, returns the data read by the previous call for the same register.
+// NOTE: only valid when the previous access to the driver was a read of the same register,
+//       used for continuous polling of the DRV_STATUS register during sensorless homing.
+TMC2130_status_t SPI_PollRegister (TMC2130_t *driver, TMC2130_datagram_t *reg)
+{
+    return spi_transfer((chip_select_t *)driver->cs_pin, reg->addr.value, &reg->payload.value);
+}
+
+static TMC2130_status_t SPI_ReadRegister (TMC2130_t *driver, TMC2130_datagram_t *reg)
+{
+    return SPI_ReadRegisters(driver, &reg, 1);
+}
+
 static TMC2130_status_t SPI_WriteRegister (TMC2130_t *driver, TMC2130_datagram_t *reg)
 {
     TMC2130_status_t status = {0};
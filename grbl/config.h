@@ -55,6 +55,11 @@
 // Experimental - testing required and homing needs to be worked out.
 //#define WALL_PLOTTER // Default disabled. Uncomment to enable.
 
+// Enables the $KV=<n> command for verifying custom kinematics. Transforms <n> pseudo random targets within
+// the work envelope to motor steps, back to cartesian and to steps again and reports the max round-trip error
+// in steps along with the time spent. Intended for development of kinematics, requires KINEMATICS_API.
+//#define KINEMATICS_VERIFY // Default disabled. Uncomment to enable.
+
 // Enable CoreXY kinematics. Use ONLY with CoreXY machines.
 // IMPORTANT: If homing is enabled, you must reconfigure the homing cycle #defines above to
 // #define HOMING_CYCLE_0 X_AXIS_BIT and #define HOMING_CYCLE_1 Y_AXIS_BIT
@@ -233,6 +238,16 @@
 // #define HOMING_AXIS_SEARCH_SCALAR  1.5f // Uncomment to override defaults in limits.c.
 // #define HOMING_AXIS_LOCATE_SCALAR  10.0f // Uncomment to override defaults in limits.c.
 
+// Sensorless homing: axes homed by stall detection (e.g. Trinamic stallGuard) are approached twice
+// at the seek rate. If the two stall positions are within this tolerance the slow locate cycle(s)
+// are skipped, else homing continues with the locate cycle(s) as for limit switches.
+// #define HOMING_SENSORLESS_TOLERANCE 0.05f // mm. Uncomment to override defaults in limits.c.
+
+// Enable to home auto squared (dual motor) axes in a single cycle along with the other axes of the homing
+// group. Each motor is stopped independently when its limit switch triggers, in every approach pass.
+// By default the locate cycles are run separately for each motor after the group is homed.
+// #define HOMING_PARALLEL_SQUARING // Default disabled. Uncomment to enable.
+
 // Enable the '$RST=*', '$RST=$', and '$RST=#' non-volatile storage restore commands. There are cases where
 // these commands may be undesirable. Simply comment the desired macro to disable it.
 // NOTE: See SETTINGS_RESTORE_ALL macro for customizing the `$RST=*` command.
@@ -278,10 +293,43 @@
 // The buffer will be written to non-volatile storage when in idle state.
 //#define BUFFER_NVSDATA_DISABLE
 
-// Max number of entries in log for PID data reporting, to be used for tuning
+// Size of the ring buffer (number of values) for streaming capture of PID loop data, to be used for tuning.
+// Captured samples are output to the active stream while the capture is running, see pid_log.c for the format.
 //#define PID_LOG 1000 // Default disabled. Uncomment to enable.
+//#define PID_LOG_DECIMATION 1 // Log every n'th sample.
 
+// Enables the core spindle synchronization module (spindle_sync.c) for spindle synchronized motion (G33, G76).
+// Drivers with an encoder capture timer report encoder pulse count and timestamp pairs, the module interpolates
+// the spindle angle between pulses and corrects the step rate of each segment with the position PID ($9x settings).
+//#define ENABLE_SPINDLE_SYNC
+
+// Enables backlash compensation, backlash is set per axis by the $16x settings. When an axis reverses
+// direction the stepper ISR injects the take-up steps without updating the machine position. The take-up
+// is spread over BACKLASH_TAKEUP_DISTANCE mm of the motion following the reversal so no extra planner
+// blocks and stops are required.
 //#define ENABLE_BACKLASH_COMPENSATION
+#ifndef BACKLASH_TAKEUP_DISTANCE
+#define BACKLASH_TAKEUP_DISTANCE 0.5f // mm
+#endif
+
+// Enables the $LR=<base64 encoded data> raster line command for laser engraving. Each byte of the data
+// sets the laser power, scaled from 0 to the programmed S value, for an equally long part of the next
+// G1 motion. Power changes are applied by the stepper ISR at the step position where the pixel starts.
+// Requires laser mode enabled and a driver with direct PWM control of the spindle.
+//#define ENABLE_LASER_RASTER
+
+// In laser mode with dynamic power (M4) the laser power is by default updated once per step segment.
+// Enable this to have the stepper ISR interpolate the power between segments on each step so that it
+// follows the instantaneous feed rate during acceleration and deceleration. This keeps the burn density
+// consistent at high acceleration, only integer math is used in the ISR.
+// Requires a driver with direct PWM control of the spindle.
+//#define ENABLE_LASER_STEP_PWM
+
+// Velocity mode jogging ($JV=) is canceled when no new setpoint is received within this time so that the
+// machine stops if the sender stops responding. Requires a driver that provides hal.get_elapsed_ticks().
+#ifndef JOG_VELOCITY_TIMEOUT
+#define JOG_VELOCITY_TIMEOUT 250 // ms
+#endif
 
 // End compile time only default configuration
 
@@ -378,6 +426,10 @@
 // repeatable. If needed, you can disable this behavior by uncommenting the define below.
 //#define ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES // Default disabled. Uncomment to enable.
 
+// Enables the $PRBG multi-point probing cycle for surface mapping. The results table reserves
+// 4 bytes of RAM per point, the maximum number of points can be set with PROBE_GRID_MAX_POINTS.
+//#define ENABLE_PROBE_GRID // Default disabled. Uncomment to enable.
+
 // Inverts logic of the stepper enable signal(s).
 // NOTE: Not universally available for individual axes - check driver documentation.
 //       Specify at least X_AXIS_BIT if a common enable signal is used.
@@ -442,9 +494,6 @@
 // #define N_TOOLS 8
 #endif
 
-// Max number of entries in log for PID data reporting, to be used for tuning
-//#define PID_LOG 1000 // Default disabled. Uncomment to enable.
-
 //#define DEFAULT_NO_REPORT_BUFFER_STATE
 //#define DEFAULT_NO_REPORT_LINE_NUMBERS
 //#define DEFAULT_NO_REPORT_CURRENT_FEED_SPEED
@@ -66,6 +66,9 @@ tool_data_t tool_table;
 
 static gc_thread_data thread;
 static output_command_t *output_commands = NULL; // Linked list
+#ifdef ENABLE_LASER_RASTER
+static raster_data_t *raster_line = NULL; // Raster data for next linear motion
+#endif
 static scale_factor_t scale_factor = {
     .ijk[X_AXIS] = 1.0f,
     .ijk[Y_AXIS] = 1.0f,
@@ -221,11 +224,13 @@ void gc_init (bool cold_start)
     }
 
     // Clear any pending output commands
-    while(output_commands) {
-        output_command_t *next = output_commands->next;
-        free(output_commands);
-        output_commands = next;
-    }
+    while(output_commands)
+        output_commands = plan_free_output_command(output_commands);
+
+#ifdef ENABLE_LASER_RASTER
+    plan_free_raster(raster_line);
+    raster_line = NULL;
+#endif
 
     // Load default override status
     gc_state.modal.override_ctrl = sys.override.control;
@@ -254,26 +259,123 @@ void gc_set_laser_ppimode (bool on)
     gc_state.is_laser_ppi_mode = on;
 }
 
-// Add output command to linked list
-static bool add_output_command (output_command_t *command)
+// Wait for queued blocks to release planner pool entries.
+// Returns false if nothing is queued for execution or on system abort.
+static bool wait_for_pool_entry (void)
 {
-    output_command_t *add_cmd;
+    if(!(plan_get_current_block() || sys.message || (sys.state & (STATE_CYCLE|STATE_HOLD|STATE_SAFETY_DOOR))))
+        return false;
 
-    if((add_cmd = malloc(sizeof(output_command_t)))) {
+    protocol_auto_cycle_start(); // Auto-cycle start as for a full planner buffer.
 
-        memcpy(add_cmd, command, sizeof(output_command_t));
+    return protocol_execute_realtime();
+}
 
-        if(output_commands == NULL)
-            output_commands = add_cmd;
-        else {
-            output_command_t *cmd = output_commands;
-            while(cmd->next)
-                cmd = cmd->next;
-            cmd->next = add_cmd;
+// Allocate storage for output command from planner pool, waits for an entry to be released if exhausted.
+static output_command_t *alloc_output_command (void)
+{
+    output_command_t *cmd;
+
+    while(!(cmd = plan_alloc_output_command()) && wait_for_pool_entry());
+
+    return cmd;
+}
+
+// Allocate storage for message from planner pool, waits for an entry to be released if exhausted.
+static char *alloc_message (void)
+{
+    char *message;
+
+    while(!(message = plan_alloc_message()) && wait_for_pool_entry());
+
+    return message;
+}
+
+// Release message and output commands not consumed by the planner.
+static void release_plan_data (plan_line_data_t *pl_data)
+{
+    if(pl_data->message) {
+        plan_free_message(pl_data->message);
+        pl_data->message = NULL;
+    }
+
+    while(pl_data->output_commands)
+        pl_data->output_commands = plan_free_output_command(pl_data->output_commands);
+}
+
+#ifdef ENABLE_LASER_RASTER
+
+static uint_fast8_t base64_value (char c)
+{
+    if(c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if(c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if(c >= '0' && c <= '9')
+        return c - '0' + 52;
+
+    return c == '+' ? 62 : (c == '/' ? 63 : 0xFF);
+}
+
+// Load raster line from base64 encoded data, one byte per pixel. Called by the $LR= system command.
+// The raster line is executed by the next linear motion (G1), stretched over the full length of the motion.
+status_code_t gc_load_raster_line (char *data)
+{
+    uint_fast8_t value;
+    uint_fast16_t bits = 0, length = 0;
+    uint32_t acc = 0;
+    raster_data_t *raster;
+
+    if(!settings.flags.laser_mode)
+        return Status_InvalidStatement;
+
+    if(raster_line)
+        raster = raster_line;
+    else while(!(raster = plan_alloc_raster()) && wait_for_pool_entry());
+
+    if(raster == NULL)
+        return sys.abort ? Status_Reset : Status_Overflow;
+
+    while(*data && *data != '=') {
+        if((value = base64_value(*data++)) == 0xFF || length == PLAN_RASTER_LENGTH) {
+            plan_free_raster(raster);
+            raster_line = NULL;
+            return length == PLAN_RASTER_LENGTH ? Status_Overflow : Status_BadNumberFormat;
         }
+        acc = (acc << 6) | value;
+        if((bits += 6) >= 8) {
+            bits -= 8;
+            raster->power[length++] = (uint8_t)(acc >> bits);
+        }
+    }
+
+    if((raster->length = length) == 0) {
+        plan_free_raster(raster);
+        raster_line = NULL;
+        return Status_BadNumberFormat;
     }
 
-    return add_cmd != NULL;
+    raster_line = raster;
+
+    return Status_OK;
+}
+
+#endif
+
+// Add output command to linked list
+static void add_output_command (output_command_t *add_cmd, output_command_t *command)
+{
+    memcpy(add_cmd, command, sizeof(output_command_t));
+    add_cmd->next = NULL;
+
+    if(output_commands == NULL)
+        output_commands = add_cmd;
+    else {
+        output_command_t *cmd = output_commands;
+        while(cmd->next)
+            cmd = cmd->next;
+        cmd->next = add_cmd;
+    }
 }
 
 static status_code_t init_sync_motion (plan_line_data_t *pl_data, float pitch)
@@ -1750,7 +1852,6 @@ status_code_t gc_execute_block(char *block, char *message)
                             bit_false(value_words, bit(Word_Q)); // Remove single-meaning value word.
                         } else if(gc_parser_flags.canned_cycle_change)
                             FAIL(Status_GcodeValueWordMissing);
-                        gc_state.canned.dwell = 0.25f;
                         break;
 
                     default:
@@ -2094,9 +2195,22 @@ status_code_t gc_execute_block(char *block, char *message)
     gc_state.line_number = gc_block.values.n;
     plan_data.line_number = gc_state.line_number; // Record data for planner use.
 
+    // [0a. Allocate storage for synchronized output command and message ]:
+    // NOTE: Waits for queued blocks to release storage if the planner pools are exhausted.
+    output_command_t *output_command = NULL;
+
+    if((port_command == 62 || port_command == 63 || port_command == 67) && (output_command = alloc_output_command()) == NULL)
+        FAIL(sys.abort ? Status_Reset : Status_Overflow); // [Too many queued output commands]
+
     // [1. Comments feedback ]: Extracted in protocol.c if HAL entry point provided
-    if(message && (plan_data.message = malloc(strlen(message) + 1)))
-        strcpy(plan_data.message, message);
+    if(message) {
+        if((plan_data.message = alloc_message()) == NULL) {
+            plan_free_output_command(output_command);
+            FAIL(sys.abort ? Status_Reset : Status_Overflow); // [Too many queued messages]
+        }
+        strncpy(plan_data.message, message, PLAN_MESSAGE_LENGTH - 1);
+        plan_data.message[PLAN_MESSAGE_LENGTH - 1] = '\0';
+    }
 
     // [2. Set feed rate mode ]:
     gc_state.modal.feed_mode = gc_block.modal.feed_mode;
@@ -2173,7 +2287,7 @@ status_code_t gc_execute_block(char *block, char *message)
 
             case 62:
             case 63:
-                add_output_command(&gc_block.output_command);
+                add_output_command(output_command, &gc_block.output_command);
                 break;
 
             case 64:
@@ -2186,7 +2300,7 @@ status_code_t gc_execute_block(char *block, char *message)
                 break;
 
             case 67:
-                add_output_command(&gc_block.output_command);
+                add_output_command(output_command, &gc_block.output_command);
                 break;
 
             case 68:
@@ -2204,8 +2318,10 @@ status_code_t gc_execute_block(char *block, char *message)
         gc_state.tool->tool = gc_state.tool_pending;
 #endif
         if(hal.tool_change) { // ATC
-            if((int_value = (uint_fast16_t)hal.tool_change(&gc_state)) != Status_OK)
+            if((int_value = (uint_fast16_t)hal.tool_change(&gc_state)) != Status_OK) {
+                release_plan_data(&plan_data);
                 FAIL((status_code_t)int_value);
+            }
             sys.report.tool = On;
         } else { // Manual
             gc_state.tool_change = true;
@@ -2425,6 +2541,10 @@ status_code_t gc_execute_block(char *block, char *message)
                 //??    gc_state.distance_per_rev = plan_data.feed_rate;
                     // check initial feed rate - fail if zero?
                 }
+#ifdef ENABLE_LASER_RASTER
+                plan_data.raster = raster_line;
+                raster_line = NULL;
+#endif
                 mc_line(gc_block.values.xyz, &plan_data);
                 break;
 
@@ -2451,8 +2571,10 @@ status_code_t gc_execute_block(char *block, char *message)
                     gc_override_flags_t overrides = sys.override.control; // Save current override disable status.
 
                     status_code_t status = init_sync_motion(&plan_data, gc_block.values.k);
-                    if(status != Status_OK)
+                    if(status != Status_OK) {
+                        release_plan_data(&plan_data);
                         FAIL(status);
+                    }
 
                     plan_data.condition.spindle.synchronized = On;
 
@@ -2470,8 +2592,10 @@ status_code_t gc_execute_block(char *block, char *message)
                     gc_override_flags_t overrides = sys.override.control; // Save current override disable status.
 
                     status_code_t status = init_sync_motion(&plan_data, thread.pitch);
-                    if(status != Status_OK)
+                    if(status != Status_OK) {
+                        release_plan_data(&plan_data);
                         FAIL(status);
+                    }
 
                     mc_thread(&plan_data, gc_state.position, &thread, overrides.feed_hold_disable);
 
@@ -2482,7 +2606,10 @@ status_code_t gc_execute_block(char *block, char *message)
             case MotionMode_DrillChipBreak:
             case MotionMode_CannedCycle81:
             case MotionMode_CannedCycle82:
-            case MotionMode_CannedCycle83:;
+            case MotionMode_CannedCycle83:
+            case MotionMode_CannedCycle85:
+            case MotionMode_CannedCycle86:
+            case MotionMode_CannedCycle89:;
                 plan_data.spindle.rpm = gc_block.values.s;
                 gc_state.canned.retract_mode = gc_state.modal.retract_mode;
                 mc_canned_drill(gc_state.modal.motion, gc_block.values.xyz, &plan_data, gc_state.position, plane, gc_block.values.l, &gc_state.canned);
@@ -2507,11 +2634,14 @@ status_code_t gc_execute_block(char *block, char *message)
             gc_update_pos = GCUpdatePos_None;
 
         //  Clean out any remaining output commands (may linger on error)
-        while(plan_data.output_commands) {
-            output_command_t *next = plan_data.output_commands;
-            free(plan_data.output_commands);
-            plan_data.output_commands = next;
-        }
+        while(plan_data.output_commands)
+            plan_data.output_commands = plan_free_output_command(plan_data.output_commands);
+
+#ifdef ENABLE_LASER_RASTER
+        // Release raster data if not queued (zero length motion or check mode)
+        plan_free_raster(plan_data.raster);
+        plan_data.raster = NULL;
+#endif
 
         // As far as the parser is concerned, the position is now == target. In reality the
         // motion control system might still be processing the action and the real tool position
@@ -2594,11 +2724,13 @@ status_code_t gc_execute_block(char *block, char *message)
             }
 
             // Clear any pending output commands
-            while(output_commands) {
-                output_command_t *next = output_commands->next;
-                free(output_commands);
-                output_commands = next;
-            }
+            while(output_commands)
+                output_commands = plan_free_output_command(output_commands);
+
+#ifdef ENABLE_LASER_RASTER
+            plan_free_raster(raster_line);
+            raster_line = NULL;
+#endif
 
             grbl.report.feedback_message(Message_ProgramEnd);
         }
@@ -564,6 +564,11 @@ status_code_t gc_execute_block(char *block, char *message);
 
 void gc_set_laser_ppimode (bool on);
 
+#ifdef ENABLE_LASER_RASTER
+// Load raster line to be executed by the next linear motion.
+status_code_t gc_load_raster_line (char *data);
+#endif
+
 // Gets axes scaling state.
 axes_signals_t gc_get_g51_state (void);
 float *gc_get_scaling (void);
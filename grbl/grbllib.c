@@ -34,6 +34,9 @@
 #include "report.h"
 #include "state_machine.h"
 #include "nvs_buffer.h"
+#ifdef ENABLE_BACKLASH_COMPENSATION
+#include "motion_control.h"
+#endif
 #ifdef KINEMATICS_API
 #include "kinematics.h"
 #endif
@@ -219,7 +222,7 @@ int grbl_enter (void)
         uint_fast16_t prior_state = sys.state;
 
         if(sys.message)
-            free(sys.message);
+            plan_free_message(sys.message);
 
         memset(&sys, 0, sizeof(system_t)); // Clear system struct variable.
         set_state(prior_state);
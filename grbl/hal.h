@@ -221,6 +221,7 @@ typedef struct {
     // grbl core events - may be subscribed to by drivers or by the core
     void (*on_state_change)(uint_fast16_t state);
     void (*on_probe_completed)(void);
+    void (*on_segment_prepared)(uint32_t *steps); // Steps per axis queued by a new step segment, called from the foreground process
     on_execute_realtime_ptr on_execute_realtime;
     void (*on_unknown_accessory_override)(uint8_t cmd);
     void (*on_report_options)(void);
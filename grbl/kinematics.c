@@ -0,0 +1,201 @@
+/*
+  kinematics.c - adaptive line segmentation for non-cartesian kinematics
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef KINEMATICS_API
+
+#include <math.h>
+#include <string.h>
+
+#include "hal.h"
+#include "settings.h"
+#include "planner.h"
+#include "kinematics.h"
+
+typedef struct {
+    bool segmented;
+    bool pending;           // Unsegmented line not yet returned
+    float length;           // Length of line (mm)
+    float distance;         // Distance from start of line to end of last segment (mm)
+    float start[N_AXIS];    // Start of line, cartesian
+    float end[N_AXIS];      // End of line, cartesian
+    float delta[N_AXIS];    // Line direction, cartesian, scaled to unit length
+    float motor[N_AXIS];    // Motor position at end of last segment
+} segmenter_t;
+
+static segmenter_t seg;
+
+static void line_position (float *position, float distance)
+{
+    uint_fast8_t idx = N_AXIS;
+
+    do {
+        idx--;
+        position[idx] = seg.start[idx] + seg.delta[idx] * distance;
+    } while(idx);
+}
+
+// Returns the max deviation between the motor position of the segment midpoint and
+// the position the motors will be at when moving linearly between the segment end points.
+static float chord_error (float *motor_end, float length)
+{
+    float position[N_AXIS], motor_mid[N_AXIS], error = 0.0f;
+    uint_fast8_t idx = N_AXIS;
+
+    line_position(position, seg.distance + length * 0.5f);
+    kinematics.transform_from_cartesian(motor_mid, position);
+
+    // End point is transformed last, implementations may cache the result for the following call from plan_target_to_steps().
+    if(seg.distance + length >= seg.length - KINEMATICS_MIN_SEGMENT_LENGTH_MM * 0.01f)
+        memcpy(position, seg.end, sizeof(position));
+    else
+        line_position(position, seg.distance + length);
+    kinematics.transform_from_cartesian(motor_end, position);
+
+    do {
+        idx--;
+        error = max(error, fabsf(motor_mid[idx] - 0.5f * (seg.motor[idx] + motor_end[idx])));
+    } while(idx);
+
+    return error;
+}
+
+// Segments lines so that the path error stays within the arc tolerance setting ($12).
+// Segment length is adjusted to the local curvature of the kinematics transform, long segments
+// are used where the transform is near linear and short where it is not.
+// May be assigned to kinematics.segment_line by kinematics implementations providing
+// kinematics.transform_from_cartesian.
+bool kinematics_adaptive_segment_line (float *target, plan_line_data_t *pl_data, bool init)
+{
+    uint_fast8_t idx = N_AXIS;
+
+    if(init) {
+
+        seg.length = 0.0f;
+
+        do {
+            idx--;
+            seg.delta[idx] = target[idx] - gc_state.position[idx];
+            seg.length += seg.delta[idx] * seg.delta[idx];
+        } while(idx);
+
+        seg.length = sqrtf(seg.length);
+
+        if((seg.segmented = !(pl_data->condition.rapid_motion || pl_data->condition.jog_motion) &&
+                             seg.length > KINEMATICS_MIN_SEGMENT_LENGTH_MM &&
+                              !(seg.delta[X_AXIS] == 0.0f && seg.delta[Y_AXIS] == 0.0f))) {
+
+            idx = N_AXIS;
+            seg.distance = 0.0f;
+            memcpy(seg.start, gc_state.position, sizeof(seg.start));
+            memcpy(seg.end, target, sizeof(seg.end));
+            kinematics.transform_from_cartesian(seg.motor, seg.start);
+
+            do {
+                seg.delta[--idx] /= seg.length;
+            } while(idx);
+        }
+
+        seg.pending = true;
+
+        return true;
+    }
+
+    if(!seg.segmented) {
+        bool pending = seg.pending;
+        seg.pending = false;
+        return pending;
+    }
+
+    if(seg.distance >= seg.length)
+        return false;
+
+    float motor_end[N_AXIS], error, tolerance = settings.arc_tolerance;
+    float length = min(seg.length - seg.distance, KINEMATICS_MAX_SEGMENT_LENGTH_MM);
+    uint_fast8_t iterations = 4;
+
+    // Chord error is proportional to the square of the segment length, use that to estimate
+    // the segment length that brings the error within tolerance.
+    while((error = chord_error(motor_end, length)) > tolerance && length > KINEMATICS_MIN_SEGMENT_LENGTH_MM && --iterations)
+        length = max(length * 0.9f * sqrtf(tolerance / error), KINEMATICS_MIN_SEGMENT_LENGTH_MM);
+
+    memcpy(seg.motor, motor_end, sizeof(seg.motor));
+
+    if((seg.distance += length) >= seg.length - KINEMATICS_MIN_SEGMENT_LENGTH_MM * 0.01f) {
+        seg.distance = seg.length;
+        memcpy(target, seg.end, sizeof(seg.end));
+    } else
+        line_position(target, seg.distance);
+
+    return true;
+}
+
+#ifdef KINEMATICS_VERIFY
+
+// Round-trip check of kinematics.plan_target_to_steps() and kinematics.convert_array_steps_to_mpos() for
+// pseudo random targets from 0 to max travel for each axis. Reports number of targets, max round-trip error
+// in steps, total time spent in ms and if the error is within one step. Called by the $KV=<n> command.
+void kinematics_verify (uint32_t n_targets)
+{
+    static uint32_t seed = 1;
+
+    uint_fast8_t idx;
+    uint32_t n = n_targets, ms = hal.get_elapsed_ticks ? hal.get_elapsed_ticks() : 0;
+    int32_t steps[N_AXIS], steps_rt[N_AXIS], error, max_error = 0;
+    float target[N_AXIS], position[N_AXIS];
+
+    while(n--) {
+
+        idx = N_AXIS;
+        do {
+            idx--;
+            seed = seed * 1664525UL + 1013904223UL;
+            target[idx] = -settings.axis[idx].max_travel * (float)(seed >> 8) / 16777216.0f;
+        } while(idx);
+
+        kinematics.plan_target_to_steps(steps, target);
+        kinematics.convert_array_steps_to_mpos(position, steps);
+        kinematics.plan_target_to_steps(steps_rt, position);
+
+        idx = N_AXIS;
+        do {
+            idx--;
+            error = steps_rt[idx] - steps[idx];
+            max_error = max(max_error, error < 0 ? -error : error);
+        } while(idx);
+    }
+
+    if(hal.get_elapsed_ticks)
+        ms = hal.get_elapsed_ticks() - ms;
+
+    hal.stream.write("[KINEMATICS:");
+    hal.stream.write(uitoa(n_targets));
+    hal.stream.write(",");
+    hal.stream.write(uitoa((uint32_t)max_error));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(ms));
+    hal.stream.write(max_error <= 1 ? ":OK]" ASCII_EOL : ":FAIL]" ASCII_EOL);
+}
+
+#endif
+
+#endif
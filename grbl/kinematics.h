@@ -22,6 +22,14 @@
 #ifndef _KINEMATICS_H_
 #define _KINEMATICS_H_
 
+// Segment length limits for kinematics_adaptive_segment_line()
+#ifndef KINEMATICS_MAX_SEGMENT_LENGTH_MM
+#define KINEMATICS_MAX_SEGMENT_LENGTH_MM 10.0f
+#endif
+#ifndef KINEMATICS_MIN_SEGMENT_LENGTH_MM
+#define KINEMATICS_MIN_SEGMENT_LENGTH_MM 0.1f
+#endif
+
 typedef struct {
     void (*convert_array_steps_to_mpos)(float *position, int32_t *steps);
     void (*plan_target_to_steps) (int32_t *target_steps, float *target);
@@ -29,8 +37,17 @@ typedef struct {
     uint_fast8_t (*limits_get_axis_mask)(uint_fast8_t idx);
     void (*limits_set_target_pos)(uint_fast8_t idx);
     void (*limits_set_machine_positions)(axes_signals_t cycle);
+    void (*transform_from_cartesian)(float *target, float *position); // Optional, cartesian (mm) to motor position (mm)
 } kinematics_t;
 
 extern kinematics_t kinematics;
 
+// Segments lines according to the local curvature of kinematics.transform_from_cartesian
+bool kinematics_adaptive_segment_line (float *target, plan_line_data_t *pl_data, bool init);
+
+#ifdef KINEMATICS_VERIFY
+// Round-trip check of the kinematics transforms
+void kinematics_verify (uint32_t n_targets);
+#endif
+
 #endif
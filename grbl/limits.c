@@ -53,6 +53,9 @@
 #ifndef HOMING_AXIS_LOCATE_SCALAR
   #define HOMING_AXIS_LOCATE_SCALAR 5.0f // Must be > 1 to ensure limit switch is cleared.
 #endif
+#ifndef HOMING_SENSORLESS_TOLERANCE
+  #define HOMING_SENSORLESS_TOLERANCE 0.05f // Max difference (mm) between stall positions for skipping locate cycle(s).
+#endif
 
 // This is the Limit Pin Change Interrupt, which handles the hard limit feature. A bouncing
 // limit switch can cause a lot of problems, like false readings and multiple interrupt calls.
@@ -135,6 +138,15 @@ static bool limits_homing_cycle (axes_signals_t cycle, axes_signals_t auto_squar
     bool approach = true, autosquare_check = false, both_motors = mode == SquaringMode_Both && auto_square.mask;
     axes_signals_t axislock, limit_state;
     plan_line_data_t plan_data;
+#ifndef KINEMATICS_API
+    // Axes with sensorless limit inputs are approached a second time at seek rate for checking stall repeatability.
+    int32_t trigger_position[N_AXIS] = {0};
+    uint_fast8_t sensorless_pass = 0;
+    bool sensorless = settings.homing.locate_cycles && !auto_square.mask && (cycle.mask & ~sys.homing_sensorless.mask) == 0;
+
+    if(sensorless)
+        n_cycle += 2;
+#endif
 
     if(mode != SquaringMode_Both)
         hal.stepper_disable_motors(auto_square, mode);
@@ -162,8 +174,10 @@ static bool limits_homing_cycle (axes_signals_t cycle, axes_signals_t auto_squar
         // NOTE: settings.max_travel[] is stored as a negative value.
         if (bit_istrue(cycle.mask, bit(idx))) {
             max_travel = max(max_travel,(-HOMING_AXIS_SEARCH_SCALAR) * settings.axis[idx].max_travel);
-            dual_motor_axis = idx;
         }
+        // Auto squared axis, checked for travel between the triggering of the two limit switches.
+        if (bit_istrue(auto_square.mask, bit(idx)))
+            dual_motor_axis = idx;
     } while(idx);
 
     if(mode == SquaringMode_Both && auto_square.mask) {
@@ -181,6 +195,14 @@ static bool limits_homing_cycle (axes_signals_t cycle, axes_signals_t auto_squar
         axislock = (axes_signals_t){0};
         n_active_axis = 0;
 
+#ifdef HOMING_PARALLEL_SQUARING
+        // Stop each motor of the auto squared axis independently in all approach passes.
+        if(approach && mode == SquaringMode_Both && auto_square.mask) {
+            both_motors = true;
+            autosquare_check = false;
+        }
+#endif
+
         idx = N_AXIS;
         do {
             // Set target location for active axes and setup computation for homing rate.
@@ -247,6 +269,7 @@ static bool limits_homing_cycle (axes_signals_t cycle, axes_signals_t auto_squar
                         axislock.mask &= ~kinematics.limits_get_axis_mask(idx);
 #else
                         axislock.mask &= ~bit(idx);
+                        trigger_position[idx] = sys_position[idx]; // Latch trigger position, steps from start of approach
 #endif
                     }
                 } while(idx);
@@ -307,12 +330,33 @@ static bool limits_homing_cycle (axes_signals_t cycle, axes_signals_t auto_squar
 
         // After first cycle, homing enters locating phase. Shorten search to pull-off distance.
         if (approach) {
+#ifndef HOMING_PARALLEL_SQUARING
             // Only one initial pass for auto squared axis when both motors are active
             if(mode == SquaringMode_Both && auto_square.mask)
                 cycle.mask &= ~auto_square.mask;
+#endif
             max_travel = settings.homing.pulloff * HOMING_AXIS_LOCATE_SCALAR;
             homing_rate = settings.homing.feed_rate;
+#ifndef KINEMATICS_API
+            // Sensorless: repeat the approach at seek rate, the trigger position should be the pull-off distance.
+            if(sensorless && ++sensorless_pass == 1)
+                homing_rate = settings.homing.seek_rate;
+#endif
         } else {
+#ifndef KINEMATICS_API
+            // Sensorless: skip locate cycle(s) if the stall position of the repeated approach is within tolerance.
+            if(sensorless && sensorless_pass == 1) {
+                bool repeatable = true;
+                idx = N_AXIS;
+                do {
+                    if (bit_istrue(cycle.mask, bit(--idx)))
+                        repeatable = repeatable && labs(labs(trigger_position[idx]) - lroundf(settings.homing.pulloff * settings.axis[idx].steps_per_mm)) <=
+                                                    lroundf(HOMING_SENSORLESS_TOLERANCE * settings.axis[idx].steps_per_mm);
+                } while(idx);
+                if(repeatable)
+                    n_cycle = 1; // Final pull-off only.
+            }
+#endif
             max_travel = settings.homing.pulloff;
             homing_rate = settings.homing.seek_rate;
         }
@@ -368,6 +412,17 @@ bool limits_go_home (axes_signals_t cycle)
 
     homed = limits_homing_cycle(cycle, auto_square, SquaringMode_Both);
 
+#ifdef HOMING_PARALLEL_SQUARING
+    // Auto squared axis located along with the other axes.
+    if(homed && auto_squared.mask & ~auto_square.mask) {
+        auto_squared.mask &= ~auto_square.mask;
+        while(homed && auto_squared.mask) {
+            auto_square.mask = auto_squared.mask & ~(auto_squared.mask - 1); // Lowest remaining auto squared axis
+            auto_squared.mask &= ~auto_square.mask;
+            homed = limits_homing_cycle(auto_square, auto_square, SquaringMode_Both);
+        }
+    }
+#else
     if(homed && auto_square.mask) {
 
         sys.homed.mask &= ~auto_square.mask;
@@ -386,6 +441,7 @@ bool limits_go_home (axes_signals_t cycle)
             homed = limits_homing_cycle(auto_square, auto_square, SquaringMode_Both);
         }
     } while(homed && auto_squared.mask);
+#endif
 
     return homed;
 }
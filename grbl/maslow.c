@@ -54,7 +54,15 @@ typedef struct {
     float height_to_bit; //distance between sled attach point and bit
 } machine_t;
 
+// Result of last inverse kinematics transform, reused if the next transform is for the same position.
+typedef struct {
+    bool valid;
+    float position[2];  // X,Y cartesian position (mm)
+    float length[2];    // A,B chain lengths (mm)
+} chain_cache_t;
+
 static machine_t machine = {0};
+static chain_cache_t chain_cache = {0};
 
 uint_fast8_t selected_motor = A_MOTOR;
 
@@ -202,8 +210,10 @@ status_code_t maslow_setting (setting_type_t param, float value, char *svalue)
             break;
     }
 
-    if(status == Status_OK)
+    if(status == Status_OK) {
+        chain_cache.valid = false;
         hal.nvs.memcpy_to_with_checksum(hal.nvs.driver_area.address, (uint8_t *)&driver_settings, sizeof(driver_settings));
+    }
 
     return status;
 }
@@ -327,6 +337,7 @@ void recomputeGeometry()
     machine.yCordOfMotor = (machine.halfHeight + maslow_hal.settings->motorOffsetY);
     machine.xCordOfMotor_x4 = machine.xCordOfMotor * 4.0f;
     machine.xCordOfMotor_x2_pow = powf((machine.xCordOfMotor * 2.0f), 2.0f);
+    chain_cache.valid = false;
 }
 
 // limit motion to stay within table (in mm)
@@ -362,7 +373,8 @@ static void maslow_convert_array_steps_to_mpos (float *position, int32_t *steps)
 
 // calculate left and right (A_MOTOR/B_MOTOR) chain lengths from X-Y cartesian coordinates  (in mm)
 // target is an absolute position in the frame
-inline static void triangularInverse (int32_t *target_steps, float *target)
+// Double precision reference version, used for verification by the kinematics test tuning command.
+static void triangularInverseD (int32_t *target_steps, float *target)
 {
     //Confirm that the coordinates are on the table
 //    verifyValidTarget(&xTarget, &yTarget);
@@ -377,6 +389,48 @@ inline static void triangularInverse (int32_t *target_steps, float *target)
     target_steps[B_MOTOR] = (int32_t)lround(sqrt(pow((double)machine.xCordOfMotor - xxx, 2.0f) + yyp) * settings.axis[B_MOTOR].steps_per_mm);
 }
 
+// Single precision version, returns chain lengths in mm.
+// The lengths are calculated from the squared horizontal and vertical distances to the motors, there is
+// no cancellation so the error vs. the double precision version is a few float ulps of the chain length,
+// about 1 micrometer for chains up to 5 meters - well below the resolution of a step.
+// The result for the previous position is reused, the adaptive line segmenter transforms the segment end
+// point before it is passed to the planner so most segments are not transformed twice.
+static void triangularInverseF (float *length, float *target)
+{
+    if(!(chain_cache.valid && chain_cache.position[X_AXIS] == target[A_MOTOR] && chain_cache.position[Y_AXIS] == target[B_MOTOR])) {
+
+        // scale target (absolute position) by any correction factor
+        float xxx = target[A_MOTOR] * maslow_hal.settings->XcorrScaling;
+        float yyy = machine.yCordOfMotor - target[B_MOTOR] * maslow_hal.settings->YcorrScaling;
+        float xa = machine.xCordOfMotor + xxx, xb = machine.xCordOfMotor - xxx;
+
+        yyy *= yyy;
+        chain_cache.valid = true;
+        chain_cache.position[X_AXIS] = target[A_MOTOR];
+        chain_cache.position[Y_AXIS] = target[B_MOTOR];
+        chain_cache.length[A_MOTOR] = sqrtf(xa * xa + yyy);
+        chain_cache.length[B_MOTOR] = sqrtf(xb * xb + yyy);
+    }
+
+    length[A_MOTOR] = chain_cache.length[A_MOTOR];
+    length[B_MOTOR] = chain_cache.length[B_MOTOR];
+}
+
+// Chain lengths in steps, define MASLOW_DOUBLE_PRECISION_IK to use the double precision version.
+inline static void triangularInverse (int32_t *target_steps, float *target)
+{
+#ifdef MASLOW_DOUBLE_PRECISION_IK
+    triangularInverseD(target_steps, target);
+#else
+    float length[2];
+
+    triangularInverseF(length, target);
+
+    target_steps[A_MOTOR] = (int32_t)lroundf(length[A_MOTOR] * settings.axis[A_MOTOR].steps_per_mm);
+    target_steps[B_MOTOR] = (int32_t)lroundf(length[B_MOTOR] * settings.axis[B_MOTOR].steps_per_mm);
+#endif
+}
+
 // Transform absolute position from cartesian coordinate system (mm) to maslow coordinate system (step)
 static void maslow_target_to_steps (int32_t *target_steps, float *target)
 {
@@ -394,59 +448,12 @@ static uint_fast8_t maslow_limits_get_axis_mask (uint_fast8_t idx)
     return ((idx == A_MOTOR) || (idx == B_MOTOR)) ? (bit(X_AXIS) | bit(Y_AXIS)) : bit(idx);
 }
 
-// MASLOW is circular in motion, so long lines must be divided up
-static bool maslow_segment_line (float *target, plan_line_data_t *pl_data, bool init)
+// Transform cartesian position to chain lengths in mm, used for adaptive line segmentation
+static void maslow_transform_from_cartesian (float *target, float *position)
 {
-    static uint_fast16_t iterations;
-    static bool segmented;
-    static float delta[N_AXIS], segment_target[N_AXIS];
-//    static plan_line_data_t plan;
-
-    uint_fast8_t idx = N_AXIS;
+    memcpy(target, position, sizeof(float) * N_AXIS);
 
-    if(init) {
-
-        float max_delta = 0.0f;
-
-        do {
-            idx--;
-            delta[idx] = target[idx] - gc_state.position[idx];
-            max_delta = max(max_delta, fabsf(delta[idx]));
-        } while(idx);
-
-        if((segmented = !(pl_data->condition.rapid_motion || pl_data->condition.jog_motion) &&
-                          max_delta > MAX_SEG_LENGTH_MM && !(delta[X_AXIS] == 0.0f && delta[Y_AXIS] == 0.0f))) {
-
-            idx = N_AXIS;
-            iterations = (uint_fast16_t)ceilf(max_delta / MAX_SEG_LENGTH_MM);
-
-            memcpy(segment_target, gc_state.position, sizeof(segment_target));
-//            memcpy(&plan, pl_data, sizeof(plan_line_data_t));
-
-            do {
-                delta[--idx] /= (float)iterations;
-                target[idx] = gc_state.position[idx];
-            } while(idx);
-
-        } else
-            iterations = 1;
-
-        iterations++; // return at least one iteration
-
-    } else {
-
-        iterations--;
-
-        if(segmented && iterations) do {
-            idx--;
-            segment_target[idx] += delta[idx];
-            target[idx] = segment_target[idx];
-//            memcpy(pl_data, &plan, sizeof(plan_line_data_t));
-        } while(idx);
-
-    }
-
-    return iterations != 0;
+    triangularInverseF(target, position);
 }
 
 static void maslow_limits_set_target_pos (uint_fast8_t idx) // fn name?
@@ -683,6 +690,14 @@ status_code_t maslow_tuning (uint_fast16_t state, char *line, char *lcline)
                                 hal.stream.write(",");
                                 hal.stream.write(uitoa((uint32_t)abz[B_MOTOR]));
 
+                                int32_t ref[N_AXIS];
+                                triangularInverseD(ref, xyz);
+                                hal.stream.write(" (double precision: ");
+                                hal.stream.write(uitoa((uint32_t)ref[A_MOTOR]));
+                                hal.stream.write(",");
+                                hal.stream.write(uitoa((uint32_t)ref[B_MOTOR]));
+                                hal.stream.write(")");
+
                                 maslow_convert_array_steps_to_mpos(xyz, abz);
                                 hal.stream.write(" -> X,Y = ");
                                 hal.stream.write(ftoa(xyz[X_AXIS], 3));
@@ -752,7 +767,8 @@ void maslow_init (void)
     kinematics.limits_set_machine_positions = maslow_limits_set_machine_positions;
     kinematics.plan_target_to_steps = maslow_target_to_steps;
     kinematics.convert_array_steps_to_mpos = maslow_convert_array_steps_to_mpos;
-    kinematics.segment_line = maslow_segment_line;
+    kinematics.transform_from_cartesian = maslow_transform_from_cartesian;
+    kinematics.segment_line = kinematics_adaptive_segment_line; // Maslow is circular in motion, so long lines must be divided up
 
     grbl.on_unknown_sys_command = maslow_tuning;
 }
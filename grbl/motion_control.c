@@ -58,30 +58,19 @@
 
 #ifdef ENABLE_BACKLASH_COMPENSATION
 
-static float target_prev[N_AXIS];
-static axes_signals_t dir_negative, backlash_enabled;
-
+// Configure backlash take-up in the stepper ISR. Slack is assumed taken up
+// in the direction of the last homing motion (pull-off) for homed axes.
 void mc_backlash_init (void)
 {
     uint_fast8_t idx = N_AXIS;
-
-    backlash_enabled.mask = dir_negative.value = 0;
+    uint32_t steps[N_AXIS];
 
     do {
-        if(settings.axis[--idx].backlash > 0.0001f)
-            backlash_enabled.mask |= bit(idx);
-        dir_negative.value |= bit(idx);
+        idx--;
+        steps[idx] = settings.axis[idx].backlash > 0.0001f ? (uint32_t)lroundf(settings.axis[idx].backlash * settings.axis[idx].steps_per_mm) : 0;
     } while(idx);
 
-    dir_negative.value ^= settings.homing.dir_mask.value;
-
-    mc_sync_backlash_position();
-}
-
-void mc_sync_backlash_position (void)
-{
-    // Update target_prev
-    system_convert_array_steps_to_mpos(target_prev, sys_position);
+    st_backlash_init(steps, (axes_signals_t){ .mask = ~settings.homing.dir_mask.value });
 }
 
 #endif
@@ -119,58 +108,6 @@ bool mc_line (float *target, plan_line_data_t *pl_data)
         // doesn't update the machine position values. Since the position values used by the g-code
         // parser and planner are separate from the system machine positions, this is doable.
 
-#ifdef ENABLE_BACKLASH_COMPENSATION
-
-        if(backlash_enabled.mask) {
-
-            bool backlash_comp = false;
-            uint_fast8_t idx = N_AXIS, axismask = bit(N_AXIS - 1);
-
-            do {
-                idx--;
-                if(backlash_enabled.mask & axismask) {
-                    if(target[idx] > target_prev[idx]) {
-                        if (dir_negative.value & axismask) {
-                            dir_negative.value &= ~axismask;
-                            target_prev[idx] += settings.axis[idx].backlash;
-                            backlash_comp = true;
-                        }
-                    } else if(target[idx] < target_prev[idx] && !(dir_negative.value & axismask)) {
-                        dir_negative.value |= axismask;
-                        target_prev[idx] -= settings.axis[idx].backlash;
-                        backlash_comp = true;
-                    }
-                }
-                axismask >>= 1;
-            } while(idx);
-
-            if(backlash_comp) {
-
-                plan_line_data_t pl_backlash;
-
-                memset(&pl_backlash, 0, sizeof(plan_line_data_t));
-
-                pl_backlash.condition.rapid_motion = On;
-                pl_backlash.condition.backlash_motion = On;
-                pl_backlash.line_number = pl_data->line_number;
-                pl_backlash.spindle.rpm = pl_data->spindle.rpm;
-
-                // If the buffer is full: good! That means we are well ahead of the robot.
-                // Remain in this loop until there is room in the buffer.
-                while(plan_check_full_buffer()) {
-                    protocol_auto_cycle_start();     // Auto-cycle start when buffer is full.
-                    if(!protocol_execute_realtime()) // Check for any run-time commands
-                        return false;                // Bail, if system abort.
-                }
-
-                plan_buffer_line(target_prev, &pl_backlash);
-            }
-
-            memcpy(target_prev, target, sizeof(float) * N_AXIS);
-        }
-
-#endif // Backlash comp
-
 #ifdef KINEMATICS_API
      kinematics.segment_line(target, pl_data, true);
 
@@ -520,6 +457,14 @@ void mc_canned_drill (motion_mode_t motion, float *target, plan_line_data_t *pl_
 
         while(current_z > canned->xyz[plane.axis_linear]) {
 
+            // G83: rapid back down to just above the bottom of the previous peck.
+            if(motion == MotionMode_CannedCycle83 && current_z < canned->retract_position) {
+                pl_data->condition.rapid_motion = On;
+                position[plane.axis_linear] = min(current_z + settings.g73_retract, canned->retract_position);
+                if(!mc_line(position, pl_data))
+                    return;
+            }
+
             current_z -= canned->delta;
             if(current_z < canned->xyz[plane.axis_linear])
                 current_z = canned->xyz[plane.axis_linear];
@@ -533,8 +478,9 @@ void mc_canned_drill (motion_mode_t motion, float *target, plan_line_data_t *pl_
             if(canned->dwell > 0.0f)
                 mc_dwell(canned->dwell);
 
-            if(canned->spindle_off)
-                hal.spindle_set_state((spindle_state_t){0}, 0.0f);
+            // Stop spindle when the bottom is reached (G86), the drill move has to complete first.
+            if(canned->spindle_off && !spindle_sync((spindle_state_t){0}, 0.0f))
+                return;
 
             // rapid retract
             switch(motion) {
@@ -708,6 +654,16 @@ void mc_thread (plan_line_data_t *pl_data, float *position, gc_thread_data *thre
     }
 }
 
+// Start execution of jog motions when idle.
+static void jog_start (void)
+{
+    if ((sys.state == STATE_IDLE || sys.state == STATE_TOOL_CHANGE) && plan_get_current_block() != NULL) { // Check if there is a block to execute.
+        set_state(STATE_JOG);
+        st_prep_buffer();
+        st_wake_up();  // NOTE: Manual start. No state machine required.
+    }
+}
+
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 status_code_t mc_jog_execute (plan_line_data_t *pl_data, parser_block_t *gc_block)
 {
@@ -725,21 +681,238 @@ status_code_t mc_jog_execute (plan_line_data_t *pl_data, parser_block_t *gc_bloc
 
     // Valid jog command. Plan, set state, and execute.
     mc_line(gc_block->values.xyz, pl_data);
-    if ((sys.state == STATE_IDLE || sys.state == STATE_TOOL_CHANGE) && plan_get_current_block() != NULL) { // Check if there is a block to execute.
-        set_state(STATE_JOG);
-        st_prep_buffer();
-        st_wake_up();  // NOTE: Manual start. No state machine required.
-    }
+    jog_start();
 
     return Status_OK;
 }
 
-// Execute dwell in seconds.
+// Jog motion API for plugin code such as MPG handwheels, bypasses the g-code parser.
+// Queues a jog motion to target (machine coordinates, mm) at feed_rate (mm/min) and updates the parser position
+// so that sequential jogs are computed correctly. The motion is planned directly, latency is thus bounded by the
+// step segment buffer and not by the input stream and parser. Each new motion is appended to the planner
+// buffer and replanned with the queued motions, so the machine only decelerates to a stop at the end of the last.
+// Never blocks and may be called from the realtime execution context, e.g. from grbl.on_execute_realtime.
+// Returns Status_Overflow when the planner buffer is full, the caller should retry with an accumulated target.
+// Returns Status_IdleError if not idle or jogging, or if program motions are queued.
+status_code_t mc_jog_target (float *target, float feed_rate)
+{
+    // Jogging is not allowed when a jog cancel or feed hold is in progress.
+    if(!(sys.state == STATE_IDLE || sys.state == STATE_TOOL_CHANGE || (sys.state == STATE_JOG && !sys.suspend)))
+        return Status_IdleError;
+
+    // When idle the planner may hold program motions waiting for cycle start, a jog can only be started from an empty planner.
+    if(sys.state != STATE_JOG && plan_get_current_block() != NULL)
+        return Status_IdleError;
+
+    if(feed_rate <= 0.0f)
+        return Status_InvalidJogCommand;
+
+    if(plan_check_full_buffer())
+        return Status_Overflow;
+
+    float jog_target[N_AXIS];
+    plan_line_data_t pl_data;
+
+    memcpy(jog_target, target, sizeof(jog_target));
+
+    if(settings.limits.flags.jog_soft_limited)
+        system_apply_jog_limits(jog_target);
+    else if (settings.limits.flags.soft_enabled && !system_check_travel_limits(jog_target))
+        return Status_TravelExceeded;
+
+    // Initialize planner data to current spindle and coolant modal state, same as for jog commands from the parser.
+    memset(&pl_data, 0, sizeof(plan_line_data_t));
+    memcpy(&pl_data.spindle, &gc_state.spindle, sizeof(spindle_t));
+    pl_data.condition.spindle = gc_state.modal.spindle;
+    pl_data.condition.coolant = gc_state.modal.coolant;
+    pl_data.condition.is_rpm_rate_adjusted = gc_state.is_rpm_rate_adjusted;
+    pl_data.feed_rate = feed_rate;
+    pl_data.condition.no_feed_override = On;
+    pl_data.condition.jog_motion = On;
+    pl_data.line_number = JOG_LINE_NUMBER;
+
+    // NOTE: mc_line() is not used here as it may block and calls protocol_execute_realtime().
+    // Jog motions are not segmented by kinematics implementations.
+    plan_buffer_line(jog_target, &pl_data);
+    memcpy(gc_state.position, jog_target, sizeof(gc_state.position));
+
+    jog_start();
+
+    return Status_OK;
+}
+
+static plan_block_t *jog_block = NULL;  // Executing velocity mode jog motion, NULL if none
+static float jog_unit_vec[N_AXIS];
+static uint32_t jog_setpoint_ms;        // Time of last setpoint received
+
+// Velocity mode jogging, for joysticks and pendants streaming speed setpoints.
+// velocity is the speed per axis in mm/min, the sign gives the direction, all zero stops the jog.
+// A single jog motion is planned towards the travel limit in the commanded direction. Subsequent calls with the
+// same direction change the rate of the executing motion in place, the step segment generator then ramps from
+// the current speed to the new without stopping. Per call cost is constant.
+// A change of direction requires a stop: the jog is canceled and Status_IdleError is returned until the machine
+// has come to a halt, the caller should keep sending the setpoint.
+// The jog is canceled if the setpoint is not repeated within JOG_VELOCITY_TIMEOUT ms, see mc_jog_velocity_check().
+// Never blocks and may be called from the realtime execution context, e.g. from grbl.on_execute_realtime.
+status_code_t mc_jog_velocity (float *velocity)
+{
+    uint_fast8_t idx = N_AXIS;
+    float speed = 0.0f, unit_vec[N_AXIS];
+    plan_block_t *block = sys.state == STATE_JOG && !sys.suspend ? plan_get_current_block() : NULL;
+    bool same_direction = block != NULL && block == jog_block && block->condition.jog_motion;
+
+    do {
+        idx--;
+        speed += velocity[idx] * velocity[idx];
+    } while(idx);
+
+    if(speed == 0.0f) {
+        if(block && jog_block)
+            system_set_exec_state_flag(EXEC_MOTION_CANCEL);
+        jog_block = NULL;
+        return Status_OK;
+    }
+
+    speed = sqrtf(speed);
+    idx = N_AXIS;
+    do {
+        idx--;
+        unit_vec[idx] = velocity[idx] / speed;
+        if(same_direction && fabsf(unit_vec[idx] - jog_unit_vec[idx]) > 0.0001f)
+            same_direction = false;
+    } while(idx);
+
+    // A jog that cannot be stopped by the setpoint timeout is not started.
+    if(hal.get_elapsed_ticks == NULL)
+        return Status_InvalidJogCommand;
+
+    if(same_direction) {
+        jog_setpoint_ms = hal.get_elapsed_ticks();
+        plan_set_block_rate(block, speed);
+        return Status_OK;
+    }
+
+    // Direction changed, decelerate to a stop before starting a new jog motion.
+    if(sys.state == STATE_JOG) {
+        if(block && jog_block) {
+            system_set_exec_state_flag(EXEC_MOTION_CANCEL);
+            jog_block = NULL;
+        }
+        return Status_IdleError;
+    }
+
+    if(!(sys.state == STATE_IDLE || sys.state == STATE_TOOL_CHANGE) || plan_get_current_block() != NULL)
+        return Status_IdleError;
+
+    // Travel until the jog soft limits or the max travel distance is reached.
+    float target[N_AXIS], distance = 0.0f;
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        distance = max(distance, -settings.axis[idx].max_travel);
+    } while(idx);
+
+    if(settings.limits.flags.jog_soft_limited || settings.limits.flags.soft_enabled) {
+
+        idx = N_AXIS;
+        do {
+            idx--;
+            target[idx] = gc_state.position[idx] + unit_vec[idx] * distance;
+        } while(idx);
+
+        system_apply_jog_limits(target);
+
+        // Shorten the motion, clamping axes individually would change the direction.
+        idx = N_AXIS;
+        do {
+            idx--;
+            if(unit_vec[idx] != 0.0f)
+                distance = min(distance, (target[idx] - gc_state.position[idx]) / unit_vec[idx]);
+        } while(idx);
+    }
+
+    if(distance < 0.001f)
+        return Status_TravelExceeded;
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        target[idx] = gc_state.position[idx] + unit_vec[idx] * distance;
+    } while(idx);
+
+    status_code_t status;
+
+    if((status = mc_jog_target(target, speed)) == Status_OK) {
+        jog_block = plan_get_current_block();
+        jog_setpoint_ms = hal.get_elapsed_ticks();
+        memcpy(jog_unit_vec, unit_vec, sizeof(jog_unit_vec));
+    }
+
+    return status;
+}
+
+// Forgets the velocity mode jog motion when it has been retired from the planner, and cancels it
+// if the setpoint has not been repeated within JOG_VELOCITY_TIMEOUT ms.
+void mc_jog_velocity_check (void)
+{
+    if(jog_block == NULL)
+        return;
+
+    if(sys.state != STATE_JOG || plan_get_current_block() != jog_block)
+        jog_block = NULL;
+    else if(hal.get_elapsed_ticks() - jog_setpoint_ms >= JOG_VELOCITY_TIMEOUT) {
+        system_set_exec_state_flag(EXEC_MOTION_CANCEL);
+        jog_block = NULL;
+    }
+}
+
+// Queues a jog motion by distance (mm) relative to the current parser position, see mc_jog_target().
+status_code_t mc_jog_relative (float *distance, float feed_rate)
+{
+    float target[N_AXIS];
+    uint_fast8_t idx = N_AXIS;
+
+    do {
+        idx--;
+        target[idx] = gc_state.position[idx] + distance[idx];
+    } while(idx);
+
+    return mc_jog_target(target, feed_rate);
+}
+
+// Execute dwell in seconds. The dwell is queued as a timed planner block, motions following
+// it are planned and prepared while it is executed.
+// NOTE: A zero dwell (G4 P0) waits for the planner buffer to empty, as it is commonly used for that.
 void mc_dwell (float seconds)
 {
     if (sys.state != STATE_CHECK_MODE) {
-        protocol_buffer_synchronize();
-        delay_sec(seconds, DelayMode_Dwell);
+
+        if(seconds <= 0.0f) {
+            protocol_buffer_synchronize();
+            return;
+        }
+
+        plan_line_data_t pl_data;
+
+        memset(&pl_data, 0, sizeof(plan_line_data_t));
+        memcpy(&pl_data.spindle, &gc_state.spindle, sizeof(spindle_t));
+        pl_data.condition.spindle = gc_state.modal.spindle;
+        pl_data.condition.coolant = gc_state.modal.coolant;
+        pl_data.condition.is_rpm_rate_adjusted = gc_state.is_rpm_rate_adjusted;
+        pl_data.line_number = gc_state.line_number;
+
+        // Remain in this loop until there is room in the buffer.
+        do {
+            if(!protocol_execute_realtime())    // Check for any run-time commands
+                return;                         // Bail, if system abort.
+            if(plan_check_full_buffer())
+                protocol_auto_cycle_start();    // Auto-cycle start when buffer is full.
+            else
+                break;
+        } while(true);
+
+        plan_buffer_dwell(seconds, &pl_data);
     }
 }
 
@@ -919,6 +1092,140 @@ gc_probe_t mc_probe_cycle (float *target, plan_line_data_t *pl_data, gc_parser_f
     return sys.flags.probe_succeeded ? GCProbe_Found : GCProbe_FailEnd;
 }
 
+#ifdef ENABLE_PROBE_GRID
+
+static probe_table_t probe_table = {0};
+
+// Returns results from the last multi-point probing cycle.
+probe_table_t *mc_get_probe_table (void)
+{
+    return &probe_table;
+}
+
+// Perform multi-point probing cycle. Requires probe switch.
+// The retract, travel and probing motions for each point are queued together so that they are
+// executed without stopping inbetween, the stepper ISR arms the probe monitor when the probing
+// motion starts. Only the remainder of the probing motion is discarded after contact.
+// Points are probed row by row in alternating direction to minimize travel.
+// NOTE: Upon probe failure, the cycle is aborted and the system placed into ALARM state.
+status_code_t mc_probe_grid (probe_grid_t *grid)
+{
+    uint_fast16_t row = 0, col;
+    float target[N_AXIS], offset[N_AXIS];
+    plan_line_data_t pl_data = {0};
+    probe_state_t probe;
+
+    memcpy(&probe_table.grid, grid, sizeof(probe_grid_t));
+    probe_table.n_probed = 0;
+
+    if (sys.state == STATE_CHECK_MODE)
+        return Status_OK;
+
+    // Finish all queued commands and empty planner buffer before starting the cycle.
+    if (!protocol_buffer_synchronize())
+        return Status_Reset; // Return if system reset has been issued.
+
+    hal.probe_configure_invert_mask(false, true);
+
+    probe = hal.probe_get_state();
+    if (probe.triggered || !probe.connected) {
+        system_set_exec_alarm(Alarm_ProbeFailInitial);
+        protocol_execute_realtime();
+        hal.probe_configure_invert_mask(false, false);
+        return Status_OK;
+    }
+
+    sys.flags.probe_succeeded = Off;
+
+    system_convert_array_steps_to_mpos(target, sys_position);
+
+    for(col = 0; col < N_AXIS; col++)
+        offset[col] = gc_get_offset(col);
+
+    do {
+        for(col = 0; col < grid->points[X_AXIS]; col++) {
+
+            uint_fast16_t x = row & 0x01 ? grid->points[X_AXIS] - col - 1 : col;
+
+            // Retract and travel to point.
+            pl_data.condition.rapid_motion = On;
+            pl_data.condition.probe_motion = Off;
+            target[Z_AXIS] = grid->clearance + offset[Z_AXIS];
+            if(!mc_line(target, &pl_data))
+                return Status_Reset;
+
+            target[X_AXIS] = grid->origin[X_AXIS] + grid->spacing[X_AXIS] * (float)x + offset[X_AXIS];
+            target[Y_AXIS] = grid->origin[Y_AXIS] + grid->spacing[Y_AXIS] * (float)row + offset[Y_AXIS];
+            if(!mc_line(target, &pl_data))
+                return Status_Reset;
+
+            // Probe.
+            pl_data.condition.rapid_motion = Off;
+            pl_data.condition.probe_motion = On;
+            pl_data.condition.no_feed_override = !settings.flags.allow_probing_feed_override;
+            pl_data.feed_rate = grid->feed_rate;
+            target[Z_AXIS] = grid->depth + offset[Z_AXIS];
+            if(!mc_line(target, &pl_data))
+                return Status_Reset;
+
+            pl_data.condition.no_feed_override = Off;
+
+            // Execute queued motions. Wait here until probe is triggered or motion completes.
+            system_set_exec_state_flag(EXEC_CYCLE_START);
+            do {
+                if(!protocol_execute_realtime()) // Check for system abort
+                    return Status_Reset;
+            } while (!(sys.state == STATE_IDLE || sys.state == STATE_TOOL_CHANGE));
+
+            // Remove the remainder of the probing motion. Nothing else is queued, no need to flush.
+            st_reset();
+            plan_reset();
+            plan_sync_position();
+
+            // st_reset() turns off the driver probing mode, restore it for the next point.
+            hal.probe_configure_invert_mask(false, true);
+
+            system_convert_array_steps_to_mpos(target, sys_position);
+
+            if(sys_probing_state == Probing_Active) {
+                sys_probing_state = Probing_Off;
+                system_set_exec_alarm(Alarm_ProbeFailContact);
+            } else {
+                float contact[N_AXIS];
+                system_convert_array_steps_to_mpos(contact, sys_probe_position);
+                // Probe triggered at start of probing motion?
+                if(contact[Z_AXIS] > grid->clearance + offset[Z_AXIS] - 1.0f / settings.axis[Z_AXIS].steps_per_mm)
+                    system_set_exec_alarm(Alarm_ProbeFailInitial);
+                else
+                    probe_table.z[row * grid->points[X_AXIS] + x] = contact[Z_AXIS] - offset[Z_AXIS];
+            }
+
+            if(sys_rt_exec_alarm)
+                break;
+
+            probe_table.n_probed++;
+        }
+    } while(!sys_rt_exec_alarm && ++row < grid->points[Y_AXIS]);
+
+    // Retract to clearance height.
+    if(!sys_rt_exec_alarm) {
+        pl_data.condition.rapid_motion = On;
+        pl_data.condition.probe_motion = Off;
+        target[Z_AXIS] = grid->clearance + offset[Z_AXIS];
+        if(!(mc_line(target, &pl_data) && protocol_buffer_synchronize()))
+            return Status_Reset;
+        sys.flags.probe_succeeded = On;
+    }
+
+    hal.probe_configure_invert_mask(false, false);
+    protocol_execute_realtime();
+
+    gc_sync_position();
+
+    return Status_OK;
+}
+
+#endif // ENABLE_PROBE_GRID
 
 // Plans and executes the single special motion case for parking. Independent of main planner buffer.
 // NOTE: Uses the always free planner ring buffer head to store motion parameters for execution.
@@ -54,6 +54,18 @@ void mc_thread (plan_line_data_t *pl_data, float *position, gc_thread_data *thre
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 status_code_t mc_jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block);
 
+// Queues a jog motion to target (machine coordinates) without involving the g-code parser, never blocks.
+status_code_t mc_jog_target (float *target, float feed_rate);
+
+// Queues a jog motion by distance relative to the current parser position, never blocks.
+status_code_t mc_jog_relative (float *distance, float feed_rate);
+
+// Velocity mode jogging, updates the rate of the executing jog motion in place, never blocks.
+status_code_t mc_jog_velocity (float *velocity);
+
+// Cancels a velocity mode jog when the setpoint has timed out, called by the realtime execution system.
+void mc_jog_velocity_check (void);
+
 // Dwell for a specific number of seconds
 void mc_dwell(float seconds);
 
@@ -63,6 +75,14 @@ status_code_t mc_homing_cycle(axes_signals_t cycle);
 // Perform tool length probe cycle. Requires probe switch.
 gc_probe_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, gc_parser_flags_t parser_flags);
 
+#ifdef ENABLE_PROBE_GRID
+// Perform multi-point probing cycle, results are stored in the probe table.
+status_code_t mc_probe_grid(probe_grid_t *grid);
+
+// Returns results from the last multi-point probing cycle.
+probe_table_t *mc_get_probe_table(void);
+#endif
+
 // Handles updating the override control state.
 void mc_override_ctrl_update(gc_override_flags_t override_state);
 
@@ -76,7 +96,6 @@ void mc_reset();
 
 #ifdef ENABLE_BACKLASH_COMPENSATION
 void mc_backlash_init (void);
-void mc_sync_backlash_position (void);
 #endif
 
 #endif
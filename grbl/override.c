@@ -30,7 +30,13 @@ typedef struct {
     uint8_t buf[OVERRIDE_BUFSIZE];
 } override_queue_t;
 
+typedef struct {
+    volatile bool set;
+    volatile uint8_t value;
+} override_value_t;
+
 static override_queue_t feed = {0}, accessory = {0};
+static override_value_t feed_value = {0}, rapid_value = {0}, spindle_value = {0};
 
 ISR_CODE void enqueue_feed_override (uint8_t cmd)
 {
@@ -80,6 +86,59 @@ uint8_t get_accessory_override (void)
     return data;
 }
 
+// Absolute override values, the last value set before the realtime execution system picks it up wins.
+// Pending values are applied before any queued relative override commands.
+
+static inline void set_override_value (override_value_t *override, uint8_t value)
+{
+    override->value = value;
+    override->set = true;
+}
+
+// Returns false if no value set
+static inline bool get_override_value (override_value_t *override, uint_fast8_t *value)
+{
+    bool set;
+
+    if((set = override->set)) {
+        override->set = false;
+        *value = override->value;
+    }
+
+    return set;
+}
+
+ISR_CODE void set_feed_override_value (uint8_t value)
+{
+    set_override_value(&feed_value, value);
+}
+
+bool get_feed_override_value (uint_fast8_t *value)
+{
+    return get_override_value(&feed_value, value);
+}
+
+ISR_CODE void set_rapid_override_value (uint8_t value)
+{
+    set_override_value(&rapid_value, value);
+}
+
+bool get_rapid_override_value (uint_fast8_t *value)
+{
+    return get_override_value(&rapid_value, value);
+}
+
+ISR_CODE void set_spindle_override_value (uint8_t value)
+{
+    set_override_value(&spindle_value, value);
+}
+
+bool get_spindle_override_value (uint_fast8_t *value)
+{
+    return get_override_value(&spindle_value, value);
+}
+
 void flush_override_buffers () {
     feed.head = feed.tail = accessory.head = accessory.tail = 0;
+    feed_value.set = rapid_value.set = spindle_value.set = false;
 }
@@ -33,5 +33,11 @@ void enqueue_feed_override (uint8_t cmd);
 uint8_t get_feed_override (void);
 void enqueue_accessory_override (uint8_t cmd);
 uint8_t get_accessory_override (void);
+void set_feed_override_value (uint8_t value);
+bool get_feed_override_value (uint_fast8_t *value);
+void set_rapid_override_value (uint8_t value);
+bool get_rapid_override_value (uint_fast8_t *value);
+void set_spindle_override_value (uint8_t value);
+bool get_spindle_override_value (uint_fast8_t *value);
 
 #endif
@@ -0,0 +1,208 @@
+/*
+  pid_log.c - streaming capture of PID loop data for tuning
+
+  Samples are written to a ring buffer by the control loop and output to the active stream
+  from the foreground process, a few samples at a time, as base64 encoded binary (little endian floats):
+
+  [PIDLOG:START,<sample time>,<channels>,<decimation>]
+  [PIDLOG:<index of first sample>|<base64 encoded samples>]
+  ...
+  [PIDLOG:END,<samples>,<dropped samples>]
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef PID_LOG
+
+#include <string.h>
+
+#include "hal.h"
+#include "report.h"
+#include "pid_log.h"
+
+typedef struct {
+    volatile bool active;
+    volatile bool stop;
+    bool header;                    // Capture header is not yet output
+    bool running;                   // Machine has been in a non-idle state during the capture
+    uint_fast8_t n_channels;
+    uint_fast16_t decimation;
+    uint_fast16_t decimate;
+    uint_fast16_t size;             // Buffer size in number of samples
+    float t_sample;
+    volatile uint_fast16_t head;
+    volatile uint_fast16_t tail;
+    uint32_t samples;
+    uint32_t output;                // Number of samples output
+    volatile uint32_t dropped;
+    float data[PID_LOG];
+} pid_log_t;
+
+static pid_log_t capture = {0};
+static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+ISR_CODE bool pid_log_start (uint_fast8_t n_channels, float t_sample, uint_fast16_t decimation)
+{
+    if(capture.active || n_channels == 0 || n_channels > PID_LOG_CHANNELS_MAX)
+        return false;
+
+    capture.n_channels = n_channels;
+    capture.size = PID_LOG / n_channels;
+    capture.t_sample = t_sample;
+    capture.decimation = decimation ? decimation : PID_LOG_DECIMATION;
+    capture.decimate = 0;
+    capture.head = capture.tail = 0;
+    capture.samples = capture.output = capture.dropped = 0;
+    capture.header = true;
+    capture.running = false;
+    capture.stop = false;
+    capture.active = true;
+
+    return true;
+}
+
+// Samples with a different number of values than the running capture are dropped, the capture
+// may have been started by another producer.
+ISR_CODE void pid_log_sample (uint_fast8_t n_channels, float *values)
+{
+    if(!capture.active || capture.stop || n_channels != capture.n_channels || ++capture.decimate < capture.decimation)
+        return;
+
+    capture.decimate = 0;
+
+    uint_fast16_t next_head = capture.head + 1;
+
+    if(next_head == capture.size)
+        next_head = 0;
+
+    if(next_head == capture.tail)
+        capture.dropped++;
+    else {
+        memcpy(&capture.data[capture.head * capture.n_channels], values, capture.n_channels * sizeof(float));
+        capture.samples++;
+        capture.head = next_head;
+    }
+}
+
+void pid_log_stop (void)
+{
+    capture.stop = capture.active;
+}
+
+static char *base64_encode (char *dest, const uint8_t *data, uint_fast16_t length)
+{
+    uint32_t acc;
+
+    while(length) {
+        acc = (uint32_t)data[0] << 16;
+        if(length > 1)
+            acc |= (uint32_t)data[1] << 8;
+        if(length > 2)
+            acc |= data[2];
+        *dest++ = base64[(acc >> 18) & 0x3F];
+        *dest++ = base64[(acc >> 12) & 0x3F];
+        *dest++ = length > 1 ? base64[(acc >> 6) & 0x3F] : '=';
+        *dest++ = length > 2 ? base64[acc & 0x3F] : '=';
+        data += length > 3 ? 3 : length;
+        length -= length > 3 ? 3 : length;
+    }
+    *dest = '\0';
+
+    return dest;
+}
+
+// Outputs at most one line per call so that the foreground process is not held up.
+// The capture ends when stopped by the producer, or when the machine changes from a running state
+// to idle, and all samples are output. A capture started while idle runs until one of these happens.
+void pid_log_drain (uint_fast16_t state)
+{
+    static float samples[PID_LOG_SAMPLES_PER_LINE * PID_LOG_CHANNELS_MAX];
+    static char line[((PID_LOG_SAMPLES_PER_LINE * PID_LOG_CHANNELS_MAX * sizeof(float) + 2) / 3) * 4 + 25];
+
+    if(!capture.active)
+        return;
+
+    if(state != STATE_IDLE)
+        capture.running = true;
+
+    if(capture.header) {
+        capture.header = false;
+        hal.stream.write("[PIDLOG:START,");
+        hal.stream.write(ftoa(capture.t_sample, N_DECIMAL_PIDVALUE));
+        hal.stream.write(",");
+        hal.stream.write(uitoa(capture.n_channels));
+        hal.stream.write(",");
+        hal.stream.write(uitoa(capture.decimation));
+        hal.stream.write("]" ASCII_EOL);
+        return;
+    }
+
+    bool end = capture.stop || (capture.running && state == STATE_IDLE);
+    uint_fast16_t n = 0, tail = capture.tail, head = capture.head;
+    uint_fast16_t available = head >= tail ? head - tail : capture.size - tail + head;
+
+    if(available >= PID_LOG_SAMPLES_PER_LINE || (available && end)) {
+
+        char *s;
+
+        while(n < available && n < PID_LOG_SAMPLES_PER_LINE) {
+            memcpy(&samples[n * capture.n_channels], &capture.data[tail * capture.n_channels], capture.n_channels * sizeof(float));
+            if(++tail == capture.size)
+                tail = 0;
+            n++;
+        }
+
+        capture.tail = tail;
+
+        strcpy(line, "[PIDLOG:");
+        strcat(line, uitoa(capture.output));
+        s = strchr(line, '\0');
+        *s++ = '|';
+        s = base64_encode(s, (uint8_t *)samples, n * capture.n_channels * sizeof(float));
+        strcpy(s, "]" ASCII_EOL);
+        hal.stream.write(line);
+
+        capture.output += n;
+
+    } else if(available == 0 && end) {
+        hal.stream.write("[PIDLOG:END,");
+        hal.stream.write(uitoa(capture.samples));
+        hal.stream.write(",");
+        hal.stream.write(uitoa(capture.dropped));
+        hal.stream.write("]" ASCII_EOL);
+        capture.active = false;
+    }
+}
+
+pid_log_status_t pid_log_get_status (void)
+{
+    pid_log_status_t status;
+
+    status.active = capture.active;
+    status.n_channels = capture.n_channels;
+    status.decimation = capture.decimation;
+    status.t_sample = capture.t_sample;
+    status.samples = capture.samples;
+    status.dropped = capture.dropped;
+
+    return status;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+  pid_log.h - streaming capture of PID loop data for tuning
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _PID_LOG_H_
+#define _PID_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PID_LOG_CHANNELS_MAX
+#define PID_LOG_CHANNELS_MAX 4
+#endif
+#ifndef PID_LOG_DECIMATION
+#define PID_LOG_DECIMATION 1 // Log every n'th sample
+#endif
+#ifndef PID_LOG_SAMPLES_PER_LINE
+#define PID_LOG_SAMPLES_PER_LINE 8
+#endif
+
+typedef struct {
+    bool active;
+    uint_fast8_t n_channels;
+    uint_fast16_t decimation;
+    float t_sample;
+    uint32_t samples;   // Number of samples logged
+    uint32_t dropped;   // Number of samples dropped due to a full buffer
+} pid_log_status_t;
+
+// Starts a capture with n_channels values per sample, no-op if a capture is already running.
+// t_sample is the sample interval in seconds (0 if not fixed), decimation 0 selects PID_LOG_DECIMATION.
+// May be called from interrupt context.
+bool pid_log_start (uint_fast8_t n_channels, float t_sample, uint_fast16_t decimation);
+
+// Adds a sample of n_channels values to the capture, never blocks. May be called from interrupt context.
+// The sample is dropped if n_channels does not match the running capture.
+void pid_log_sample (uint_fast8_t n_channels, float *values);
+
+// Ends the capture when the buffered samples has been output.
+void pid_log_stop (void);
+
+// Outputs buffered samples to the active stream, called by the realtime execution system.
+void pid_log_drain (uint_fast16_t state);
+
+pid_log_status_t pid_log_get_status (void);
+
+#endif
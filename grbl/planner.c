@@ -48,6 +48,19 @@ static plan_block_t *block_buffer_planned;              // Pointer to the optima
 
 static planner_t pl;
 
+#define POOL_WORDS(size) (((size) + 15) >> 4)
+
+// Message and output command pools, free entries are tracked in bitmaps with 16 entries per word
+// to allow entries to be released from interrupt context with the HAL atomic bit functions.
+static char message_pool[PLAN_MESSAGE_POOL_SIZE][PLAN_MESSAGE_LENGTH];
+static output_command_t output_command_pool[PLAN_OUTPUT_COMMAND_POOL_SIZE];
+static volatile uint_fast16_t message_free[POOL_WORDS(PLAN_MESSAGE_POOL_SIZE)];
+static volatile uint_fast16_t output_command_free[POOL_WORDS(PLAN_OUTPUT_COMMAND_POOL_SIZE)];
+#ifdef ENABLE_LASER_RASTER
+static raster_data_t raster_pool[PLAN_RASTER_POOL_SIZE];
+static volatile uint_fast16_t raster_free[POOL_WORDS(PLAN_RASTER_POOL_SIZE)];
+#endif
+
 
 /*                            PLANNER SPEED DEFINITION
                                      +--------+   <- current->nominal_speed
@@ -188,18 +201,108 @@ static void planner_recalculate ()
     }
 }
 
+static void pool_init (volatile uint_fast16_t *map, uint_fast16_t size)
+{
+    uint_fast16_t idx;
+
+    for(idx = 0; idx < POOL_WORDS(size); idx++)
+        map[idx] = size - (idx << 4) >= 16 ? 0xFFFF : (uint_fast16_t)(bit((size - (idx << 4))) - 1);
+}
+
+// Claims the first free entry in the bitmap, returns -1 if none.
+// NOTE: Entries are only claimed by the foreground process so a free entry
+//       cannot be lost between the test and the atomic clear below.
+static int_fast16_t pool_claim (volatile uint_fast16_t *map, uint_fast16_t size)
+{
+    uint_fast16_t word = 0, idx;
+
+    do {
+        if(map[word]) {
+            idx = 0;
+            while(!(map[word] & bit(idx)))
+                idx++;
+            hal.clear_bits_atomic(&map[word], bit(idx));
+            return (int_fast16_t)((word << 4) + idx);
+        }
+    } while(++word < POOL_WORDS(size));
+
+    return -1;
+}
+
+char *plan_alloc_message (void)
+{
+    int_fast16_t idx = pool_claim(message_free, PLAN_MESSAGE_POOL_SIZE);
+
+    return idx < 0 ? NULL : message_pool[idx];
+}
+
+output_command_t *plan_alloc_output_command (void)
+{
+    int_fast16_t idx = pool_claim(output_command_free, PLAN_OUTPUT_COMMAND_POOL_SIZE);
+
+    return idx < 0 ? NULL : &output_command_pool[idx];
+}
+
+ISR_CODE void plan_free_message (char *message)
+{
+    if(message) {
+        uint_fast16_t idx = (uint_fast16_t)((message - message_pool[0]) / PLAN_MESSAGE_LENGTH);
+        if(idx < PLAN_MESSAGE_POOL_SIZE)
+            hal.set_bits_atomic(&message_free[idx >> 4], bit((idx & 0x0F)));
+    }
+}
+
+ISR_CODE output_command_t *plan_free_output_command (output_command_t *command)
+{
+    output_command_t *next = NULL;
+
+    if(command) {
+        uint_fast16_t idx = (uint_fast16_t)(command - output_command_pool);
+        next = command->next;
+        if(idx < PLAN_OUTPUT_COMMAND_POOL_SIZE)
+            hal.set_bits_atomic(&output_command_free[idx >> 4], bit((idx & 0x0F)));
+    }
+
+    return next;
+}
+
+#ifdef ENABLE_LASER_RASTER
+
+raster_data_t *plan_alloc_raster (void)
+{
+    int_fast16_t idx = pool_claim(raster_free, PLAN_RASTER_POOL_SIZE);
+
+    return idx < 0 ? NULL : &raster_pool[idx];
+}
+
+ISR_CODE void plan_free_raster (raster_data_t *raster)
+{
+    if(raster) {
+        uint_fast16_t idx = (uint_fast16_t)(raster - raster_pool);
+        if(idx < PLAN_RASTER_POOL_SIZE)
+            hal.set_bits_atomic(&raster_free[idx >> 4], bit((idx & 0x0F)));
+    }
+}
+
+#endif
+
+// Releases messages and output commands not yet handed over to the stepper module.
 inline static void plan_cleanup (plan_block_t *block)
 {
     if(block->message) {
-        free(block->message);
+        plan_free_message(block->message);
         block->message = NULL;
     }
 
-    while(block->output_commands) {
-        output_command_t *next = block->output_commands->next;
-        free(block->output_commands);
-        block->output_commands = next;
+    while(block->output_commands)
+        block->output_commands = plan_free_output_command(block->output_commands);
+
+#ifdef ENABLE_LASER_RASTER
+    if(block->raster) {
+        plan_free_raster(block->raster);
+        block->raster = NULL;
     }
+#endif
 }
 
 
@@ -232,6 +335,14 @@ void plan_reset ()
         block_buffer[idx].next = &block_buffer[idx == BLOCK_BUFFER_SIZE - 1 ? 0 : idx + 1];
     }
 
+    if(!soft_reset) {
+        pool_init(message_free, PLAN_MESSAGE_POOL_SIZE);
+        pool_init(output_command_free, PLAN_OUTPUT_COMMAND_POOL_SIZE);
+#ifdef ENABLE_LASER_RASTER
+        pool_init(raster_free, PLAN_RASTER_POOL_SIZE);
+#endif
+    }
+
     plan_reset_buffer(soft_reset);
     soft_reset = true;
 }
@@ -379,6 +490,9 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
     block->line_number = pl_data->line_number;
     block->message = pl_data->message;
     block->output_commands = pl_data->output_commands;
+#ifdef ENABLE_LASER_RASTER
+    block->raster = pl_data->raster;
+#endif
 
     // Copy position data based on type of motion being planned.
     memcpy(position_steps, block->condition.system_motion ? sys_position : pl.position, sizeof(position_steps));
@@ -433,6 +547,9 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 
     pl_data->message = NULL;         // Indicate message is already queued for display on execution
     pl_data->output_commands = NULL; // Indicate commands are already queued for execution
+#ifdef ENABLE_LASER_RASTER
+    pl_data->raster = NULL;          // Indicate raster data is already queued for execution
+#endif
 
     // Calculate the unit vector of the line move and the block maximum feed rate and acceleration scaled
     // down such that no individual axes maximum values are exceeded with respect to the line direction.
@@ -452,7 +569,7 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
     }
 
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
-    if ((block_buffer_head == block_buffer_tail) || (block->condition.system_motion)) {
+    if ((block_buffer_head == block_buffer_tail) || (block->condition.system_motion) || block_buffer_head->prev->condition.dwell) {
 
         // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
         // If system motion, the system motion block always is assumed to start from rest and end at a complete stop.
@@ -514,11 +631,9 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 
         pl.previous_nominal_speed = plan_compute_profile_parameters(block, plan_compute_profile_nominal_speed(block), pl.previous_nominal_speed);
 
-        if(!block->condition.backlash_motion) {
-            // Update previous path unit_vector and planner position.
-            memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
-            memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
-        }
+        // Update previous path unit_vector and planner position.
+        memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
+        memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
         // New block is all set. Update buffer head and next buffer head indices.
         block_buffer_head = next_buffer_head;
         next_buffer_head = block_buffer_head->next;
@@ -531,6 +646,42 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 }
 
 
+/* Add a timed dwell to the buffer. The dwell block has no motion, it is planned with zero entry
+   and exit speed so the preceding motion decelerates to a stop and the following motion starts
+   from rest. The stepper module executes it as empty step segments, following motions are planned
+   and prepared while the dwell is in progress so execution resumes without waiting for a refill.
+   NOTE: Assumes buffer is available. Buffer checks are handled at a higher level by motion_control. */
+bool plan_buffer_dwell (float seconds, plan_line_data_t *pl_data)
+{
+    plan_block_t *block = block_buffer_head;
+
+    memset(block, 0, sizeof(plan_block_t) - 2 * sizeof(plan_block_t *));    // Zero all block values (except linked list pointers).
+    memcpy(&block->spindle, &pl_data->spindle, sizeof(spindle_t));          // Copy spindle data (RPM etc)
+    block->condition = pl_data->condition;
+    block->condition.dwell = On;
+    block->overrides = pl_data->overrides;
+    block->line_number = pl_data->line_number;
+    block->message = pl_data->message;
+    block->output_commands = pl_data->output_commands;
+    block->direction_bits = block_buffer_head->prev->direction_bits; // Keep direction outputs unchanged.
+    block->dwell = seconds / 60.0f;
+    block->acceleration = SOME_LARGE_VALUE; // Not used, nonzero to avoid division by zero.
+
+    pl_data->message = NULL;         // Indicate message is already queued for display on execution
+    pl_data->output_commands = NULL; // Indicate commands are already queued for execution
+
+    // Stop before and start from rest after the dwell.
+    block->entry_speed_sqr = block->max_junction_speed_sqr = 0.0f;
+    pl.previous_nominal_speed = plan_compute_profile_parameters(block, plan_compute_profile_nominal_speed(block), pl.previous_nominal_speed);
+
+    block_buffer_head = next_buffer_head;
+    next_buffer_head = block_buffer_head->next;
+
+    planner_recalculate();
+
+    return true;
+}
+
 // Reset the planner position vectors. Called by the system abort/initialization routine.
 void plan_sync_position ()
 {
@@ -557,6 +708,17 @@ void plan_cycle_reinitialize ()
     planner_recalculate();
 }
 
+// Change the programmed rate of a queued or executing block in place and replan.
+// The stepper segment generator ramps from the current speed to the new rate without stopping.
+void plan_set_block_rate (plan_block_t *block, float rate)
+{
+    if(block->programmed_rate != rate) {
+        block->programmed_rate = rate;
+        plan_update_velocity_profile_parameters();
+        plan_cycle_reinitialize();
+    }
+}
+
 // Set feed overrides
 void plan_feed_override (uint_fast8_t feed_override, uint_fast8_t rapid_override)
 {
@@ -564,6 +726,7 @@ void plan_feed_override (uint_fast8_t feed_override, uint_fast8_t rapid_override
         return;
 
     feed_override = max(min(feed_override, MAX_FEED_RATE_OVERRIDE), MIN_FEED_RATE_OVERRIDE);
+    rapid_override = max(min(rapid_override, DEFAULT_RAPID_OVERRIDE), RAPID_OVERRIDE_LOW);
 
     if ((feed_override != sys.override.feed_rate) || (rapid_override != sys.override.rapid_rate)) {
       sys.override.feed_rate = (uint8_t)feed_override;
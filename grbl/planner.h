@@ -29,19 +29,48 @@
   #define BLOCK_BUFFER_SIZE 36
 #endif
 
+// Number of (MSG,...) messages and synchronized output commands (M62, M63 and M67) that can be
+// queued for execution. Storage is allocated from fixed size pools owned by the planner.
+// NOTE: Messages longer than PLAN_MESSAGE_LENGTH - 1 characters are truncated.
+#ifndef PLAN_MESSAGE_POOL_SIZE
+  #define PLAN_MESSAGE_POOL_SIZE 4
+#endif
+#ifndef PLAN_MESSAGE_LENGTH
+  #define PLAN_MESSAGE_LENGTH 128
+#endif
+#ifndef PLAN_OUTPUT_COMMAND_POOL_SIZE
+  #define PLAN_OUTPUT_COMMAND_POOL_SIZE 32
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+// Number of raster lines ($LR) that can be queued for execution and max number of pixels in a line.
+#ifndef PLAN_RASTER_POOL_SIZE
+  #define PLAN_RASTER_POOL_SIZE 4
+#endif
+#ifndef PLAN_RASTER_LENGTH
+  #define PLAN_RASTER_LENGTH 96
+#endif
+
+typedef struct {
+    uint_fast16_t length;               // Number of pixels
+    uint8_t power[PLAN_RASTER_LENGTH];  // Laser power per pixel, 0 - 255
+} raster_data_t;
+#endif
+
 typedef union {
     uint32_t value;
     struct {
         uint16_t rapid_motion         :1,
                  system_motion        :1,
                  jog_motion           :1,
-                 backlash_motion      :1,
                  no_feed_override     :1,
                  inverse_time         :1,
                  is_rpm_rate_adjusted :1,
                  is_rpm_pos_adjusted  :1,
                  is_laser_ppi_mode    :1,
-                 unassigned           :7;
+                 probe_motion         :1,
+                 dwell                :1,
+                 unassigned           :6;
         spindle_state_t spindle;
         coolant_state_t coolant;
     };
@@ -74,12 +103,17 @@ typedef struct plan_block {
     float max_junction_speed_sqr; // Junction entry speed limit based on direction vectors in (mm/min)^2
     float rapid_rate;             // Axis-limit adjusted maximum rate for this block direction in (mm/min)
     float programmed_rate;        // Programmed rate of this block (mm/min).
+    float dwell;                  // Remaining dwell time of a timed dwell block (min).
+                                  // NOTE: This value is altered by stepper algorithm during execution.
 
     // Stored spindle speed data used by spindle overrides and resuming methods.
     spindle_t spindle;    // Block spindle speed. Copied from pl_line_data.
 
     char *message;                // Message to be displayed when block is executed.
     output_command_t *output_commands;
+#ifdef ENABLE_LASER_RASTER
+    raster_data_t *raster;        // Laser power per pixel, set for raster lines.
+#endif
     struct plan_block *prev, *next; // Linked list pointers, DO NOT MOVE - these MUST be the last elements in the struct!
 } plan_block_t;
 
@@ -94,6 +128,9 @@ typedef struct {
 //    void *parameters;               // TODO: pointer to extra parameters, for canned cycles and threading?
     char *message;                  // Message to be displayed when block is executed.
     output_command_t *output_commands;
+#ifdef ENABLE_LASER_RASTER
+    raster_data_t *raster;          // Laser power per pixel for raster lines.
+#endif
 } plan_line_data_t;
 
 
@@ -115,6 +152,10 @@ void plan_reset(); // Reset all
 // rate is taken to mean "frequency" and would complete the operation in 1/feed_rate minutes.
 bool plan_buffer_line(float *target, plan_line_data_t *pl_data);
 
+// Add a timed dwell to the buffer. The dwell is executed by the stepper module without motion,
+// motions following it are planned and prepared while it is executed.
+bool plan_buffer_dwell (float seconds, plan_line_data_t *pl_data);
+
 // Called when the current block is no longer needed. Discards the block and makes the memory
 // availible for new blocks.
 void plan_discard_current_block();
@@ -149,4 +190,22 @@ bool plan_check_full_buffer();
 void plan_get_planner_mpos(float *target);
 void plan_feed_override (uint_fast8_t feed_override, uint_fast8_t rapid_override);
 
+// Changes the programmed rate of a block in place, used for velocity mode jogging.
+void plan_set_block_rate (plan_block_t *block, float rate);
+
+// Allocates storage for a message or an output command, returns NULL if the pool is exhausted.
+// NOTE: Only to be called by the foreground process.
+char *plan_alloc_message (void);
+output_command_t *plan_alloc_output_command (void);
+
+// Releases storage allocated by the functions above, may be called from interrupt context.
+// plan_free_output_command() returns the next command in the list.
+void plan_free_message (char *message);
+output_command_t *plan_free_output_command (output_command_t *command);
+
+#ifdef ENABLE_LASER_RASTER
+raster_data_t *plan_alloc_raster (void);
+void plan_free_raster (raster_data_t *raster);
+#endif
+
 #endif
@@ -38,4 +38,30 @@ typedef union {
     };
 } probe_state_t;
 
+#ifdef ENABLE_PROBE_GRID
+
+// Max number of points in a multi-point probing grid ($PRBG).
+#ifndef PROBE_GRID_MAX_POINTS
+#define PROBE_GRID_MAX_POINTS 400
+#endif
+
+// Multi-point probing grid parameters, coordinates are in work coordinates (mm).
+typedef struct {
+    float origin[2];        // X and Y of first point
+    float spacing[2];       // Distance between points along X and Y
+    uint16_t points[2];     // Number of points along X and Y
+    float clearance;        // Z height for travel motions between points
+    float depth;            // Z target of probing motions
+    float feed_rate;        // Probing feed rate (mm/min)
+} probe_grid_t;
+
+// Multi-point probing results, probed Z values are stored row by row in work coordinates.
+typedef struct {
+    probe_grid_t grid;
+    uint_fast16_t n_probed; // Number of points probed, grid is complete when equal to number of points
+    float z[PROBE_GRID_MAX_POINTS];
+} probe_table_t;
+
+#endif // ENABLE_PROBE_GRID
+
 #endif
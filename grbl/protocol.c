@@ -33,6 +33,9 @@
 #include "motion_control.h"
 #include "sleep.h"
 #include "protocol.h"
+#ifdef PID_LOG
+#include "pid_log.h"
+#endif
 
 #ifndef RT_QUEUE_SIZE
 #define RT_QUEUE_SIZE 4 // must be a power of 2
@@ -396,11 +399,11 @@ void protocol_message (char *message)
 
     if(message) {
         if(sys.message)
-            free(sys.message);
+            plan_free_message(sys.message);
         sys.message = message;
     } else if(sys.message) {
         hal.show_message(sys.message);
-        free(sys.message);
+        plan_free_message(sys.message);
         sys.message = NULL;
     }
 
@@ -537,15 +540,26 @@ bool protocol_exec_rt_system ()
 
     grbl.on_execute_realtime(sys.state);
 
+    mc_jog_velocity_check();
+
+#ifdef PID_LOG
+    pid_log_drain(sys.state);
+#endif
+
     if(!sys.flags.delay_overrides) {
 
         // Execute overrides.
 
-        if((rt_exec = get_feed_override())) {
+        uint_fast8_t new_f_override = sys.override.feed_rate, new_r_override = sys.override.rapid_rate;
+        bool update_feed_override = get_feed_override_value(&new_f_override);
 
-            uint_fast8_t new_f_override = sys.override.feed_rate, new_r_override = sys.override.rapid_rate;
+        if(get_rapid_override_value(&new_r_override))
+            update_feed_override = true;
 
-            do {
+        // All pending feed and rapid override changes are coalesced into a single replan.
+        if((rt_exec = get_feed_override()) || update_feed_override) {
+
+            if(rt_exec) do {
 
                 switch(rt_exec) {
 
@@ -587,6 +601,11 @@ bool protocol_exec_rt_system ()
             plan_feed_override(new_f_override, new_r_override);
         }
 
+        uint_fast8_t new_s_override = sys.override.spindle_rpm;
+
+        if(get_spindle_override_value(&new_s_override))
+            spindle_set_override(new_s_override);
+
         if((rt_exec = get_accessory_override())) {
 
             bool spindle_stop = false;
@@ -34,6 +34,10 @@
 #include "hal.h"
 #include "report.h"
 #include "nvs_buffer.h"
+#include "motion_control.h"
+#ifdef PID_LOG
+#include "pid_log.h"
+#endif
 
 #ifdef ENABLE_SPINDLE_LINEARIZATION
 #include <stdio.h>
@@ -356,7 +360,7 @@ void report_init_message (void)
 // Grbl help message
 void report_grbl_help (void)
 {
-    hal.stream.write("[HLP:$$ $# $G $I $N $x=val $Nx=line $J=line $SLP $C $X $H $B ~ ! ? ctrl-x]" ASCII_EOL);
+    hal.stream.write("[HLP:$$ $# $G $I $N $x=val $Nx=line $J=line $JV=rates $SLP $C $X $H $B ~ ! ? ctrl-x]" ASCII_EOL);
 }
 
 
@@ -598,6 +602,45 @@ void report_probe_parameters (void)
     hal.stream.write("]" ASCII_EOL);
 }
 
+#ifdef ENABLE_PROBE_GRID
+
+// Prints results from the last multi-point probing cycle, one line per completed row.
+// Values are in work coordinates at the time of probing.
+void report_probe_table (void)
+{
+    uint_fast16_t row, col, rows;
+    probe_table_t *table = mc_get_probe_table();
+
+    rows = table->grid.points[X_AXIS] ? table->n_probed / table->grid.points[X_AXIS] : 0;
+
+    hal.stream.write("[PRBG:");
+    hal.stream.write(get_axis_value(table->grid.origin[X_AXIS]));
+    hal.stream.write(",");
+    hal.stream.write(get_axis_value(table->grid.origin[Y_AXIS]));
+    hal.stream.write(",");
+    hal.stream.write(get_axis_value(table->grid.spacing[X_AXIS]));
+    hal.stream.write(",");
+    hal.stream.write(get_axis_value(table->grid.spacing[Y_AXIS]));
+    hal.stream.write(",");
+    hal.stream.write(uitoa((uint32_t)table->grid.points[X_AXIS]));
+    hal.stream.write(",");
+    hal.stream.write(uitoa((uint32_t)table->grid.points[Y_AXIS]));
+    hal.stream.write(rows && rows == table->grid.points[Y_AXIS] ? ":1" : ":0");
+    hal.stream.write("]" ASCII_EOL);
+
+    for(row = 0; row < rows; row++) {
+        hal.stream.write("[PRBZ:");
+        hal.stream.write(uitoa((uint32_t)row));
+        for(col = 0; col < table->grid.points[X_AXIS]; col++) {
+            hal.stream.write(col ? "," : ":");
+            hal.stream.write(get_axis_value(table->z[row * table->grid.points[X_AXIS] + col]));
+        }
+        hal.stream.write("]" ASCII_EOL);
+    }
+}
+
+#endif
+
 // Prints current home position in terms of machine position.
 // Bitmask for homed axes attached.
 void report_home_position (void)
@@ -1329,23 +1372,20 @@ void report_realtime_status (void)
 void report_pid_log (void)
 {
 #ifdef PID_LOG
-    uint_fast16_t idx = 0;
+    // Captured data is streamed while the capture is running, report capture status only.
+    pid_log_status_t status = pid_log_get_status();
 
     hal.stream.write("[PID:");
-    hal.stream.write(ftoa(sys.pid_log.setpoint, N_DECIMAL_PIDVALUE));
+    hal.stream.write(status.active ? "1," : "0,");
+    hal.stream.write(ftoa(status.t_sample, N_DECIMAL_PIDVALUE));
     hal.stream.write(",");
-    hal.stream.write(ftoa(sys.pid_log.t_sample, N_DECIMAL_PIDVALUE));
-    hal.stream.write(",2|"); // 2 is number of values per sample!
-
-    if(sys.pid_log.idx) do {
-        hal.stream.write(ftoa(sys.pid_log.target[idx], N_DECIMAL_PIDVALUE));
-        hal.stream.write(",");
-        hal.stream.write(ftoa(sys.pid_log.actual[idx], N_DECIMAL_PIDVALUE));
-        idx++;
-        if(idx != sys.pid_log.idx)
-            hal.stream.write(",");
-    } while(idx != sys.pid_log.idx);
-
+    hal.stream.write(uitoa(status.n_channels));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(status.decimation));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(status.samples));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(status.dropped));
     hal.stream.write("]" ASCII_EOL);
     grbl.report.status_message(Status_OK);
 #else
@@ -59,6 +59,11 @@ void report_realtime_status (void);
 // Prints recorded probe position.
 void report_probe_parameters (void);
 
+// Prints results from the last multi-point probing cycle.
+#ifdef ENABLE_PROBE_GRID
+void report_probe_table (void);
+#endif
+
 // Prints current tool offsets.
 void report_tool_offsets (void);
 
@@ -33,6 +33,9 @@
 #include "limits.h"
 #include "nvs_buffer.h"
 #include "tool_change.h"
+#ifdef ENABLE_BACKLASH_COMPENSATION
+#include "motion_control.h"
+#endif
 
 #ifdef ENABLE_SPINDLE_LINEARIZATION
 #include <stdio.h>
@@ -22,6 +22,7 @@
 */
 
 #include <math.h>
+#include <string.h>
 
 #include "hal.h"
 #include "protocol.h"
@@ -162,6 +163,41 @@ static inline uint_fast16_t invert_pwm (spindle_pwm_t *pwm_data, uint_fast16_t p
     return pwm_data->invert_pwm ? pwm_data->period - pwm_value - 1 : pwm_value;
 }
 
+// Spindle RPM to PWM conversion, floating point version.
+static uint_fast16_t compute_pwm_value (spindle_pwm_t *pwm_data, float rpm, bool pid_limit)
+{
+    uint_fast16_t pwm_value;
+
+    if(rpm > settings.spindle.rpm_min) {
+      #ifdef ENABLE_SPINDLE_LINEARIZATION
+        // Compute intermediate PWM value with linear spindle speed model via piecewise linear fit model.
+        uint_fast8_t idx = pwm_data->n_pieces;
+
+        if(idx) {
+            do {
+                idx--;
+                if(idx == 0 || rpm > pwm_data->piece[idx].rpm) {
+                    pwm_value = floorf(pwm_data->piece[idx].start * rpm - pwm_data->piece[idx].end);
+                    break;
+                }
+            } while(idx);
+        } else
+      #endif
+        // Compute intermediate PWM value with linear spindle speed model.
+        pwm_value = (uint_fast16_t)floorf((rpm - settings.spindle.rpm_min) * pwm_data->pwm_gradient) + pwm_data->min_value;
+
+        if(pwm_value >= (pid_limit ? pwm_data->period : pwm_data->max_value))
+            pwm_value = pid_limit ? pwm_data->period - 1 : pwm_data->max_value;
+        else if(pwm_value < pwm_data->min_value)
+            pwm_value = pwm_data->min_value;
+
+        pwm_value = invert_pwm(pwm_data, pwm_value);
+    } else
+        pwm_value = rpm == 0.0f ? pwm_data->off_value : invert_pwm(pwm_data, pwm_data->min_value);
+
+    return pwm_value;
+}
+
 // Precompute PWM values for faster conversion.
 // Returns false if no PWM range possible, driver should revert to simple on/off spindle control if so.
 bool spindle_precompute_pwm_values (spindle_pwm_t *pwm_data, uint32_t clock_hz)
@@ -189,40 +225,37 @@ bool spindle_precompute_pwm_values (spindle_pwm_t *pwm_data, uint32_t clock_hz)
     }
 #endif
 
+    // Build lookup table with linearization, clamping and inversion baked in.
+    pwm_data->lut_scale = 0.0f;
+
+    if(settings.spindle.rpm_max > settings.spindle.rpm_min) {
+        uint_fast16_t i;
+        float rpm_step = (settings.spindle.rpm_max - settings.spindle.rpm_min) / (float)SPINDLE_PWM_LUT_SIZE;
+        for(i = 0; i < SPINDLE_PWM_LUT_SIZE; i++)
+            pwm_data->lut[i] = (uint16_t)compute_pwm_value(pwm_data, settings.spindle.rpm_min + rpm_step * (float)i, false);
+        pwm_data->lut[SPINDLE_PWM_LUT_SIZE] = (uint16_t)compute_pwm_value(pwm_data, settings.spindle.rpm_max, false);
+        pwm_data->lut_scale = 256.0f / rpm_step;
+    }
+
     return settings.spindle.rpm_max > settings.spindle.rpm_min;
 }
 
 // Spindle RPM to PWM conversion.
+// Uses the lookup table with linear interpolation between entries when available.
 uint_fast16_t spindle_compute_pwm_value (spindle_pwm_t *pwm_data, float rpm, bool pid_limit)
 {
-    uint_fast16_t pwm_value;
+    if(pid_limit || pwm_data->lut_scale == 0.0f || rpm <= settings.spindle.rpm_min)
+        return compute_pwm_value(pwm_data, rpm, pid_limit);
 
-    if(rpm > settings.spindle.rpm_min) {
-      #ifdef ENABLE_SPINDLE_LINEARIZATION
-        // Compute intermediate PWM value with linear spindle speed model via piecewise linear fit model.
-        uint_fast8_t idx = pwm_data->n_pieces;
+    if(rpm >= settings.spindle.rpm_max)
+        return pwm_data->lut[SPINDLE_PWM_LUT_SIZE];
 
-        if(idx) {
-            do {
-                idx--;
-                if(idx == 0 || rpm > pwm_data->piece[idx].rpm) {
-                    pwm_value = floorf(pwm_data->piece[idx].start * rpm - pwm_data->piece[idx].end);
-                    break;
-                }
-            } while(idx);
-        } else
-      #endif
-        // Compute intermediate PWM value with linear spindle speed model.
-        pwm_value = (uint_fast16_t)floorf((rpm - settings.spindle.rpm_min) * pwm_data->pwm_gradient) + pwm_data->min_value;
+    uint32_t pos = (uint32_t)((rpm - settings.spindle.rpm_min) * pwm_data->lut_scale);
 
-        if(pwm_value >= (pid_limit ? pwm_data->period : pwm_data->max_value))
-            pwm_value = pid_limit ? pwm_data->period - 1 : pwm_data->max_value;
-        else if(pwm_value < pwm_data->min_value)
-            pwm_value = pwm_data->min_value;
+    if((pos >> 8) >= SPINDLE_PWM_LUT_SIZE) // Rounding at upper end of table
+        return pwm_data->lut[SPINDLE_PWM_LUT_SIZE];
 
-        pwm_value = invert_pwm(pwm_data, pwm_value);
-    } else
-        pwm_value = rpm == 0.0f ? pwm_data->off_value : invert_pwm(pwm_data, pwm_data->min_value);
+    uint16_t *entry = &pwm_data->lut[pos >> 8];
 
-    return pwm_value;
+    return (uint_fast16_t)((int32_t)entry[0] + ((int32_t)entry[1] - (int32_t)entry[0]) * (int32_t)(pos & 0xFF) / 256);
 }
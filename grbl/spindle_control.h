@@ -45,6 +45,11 @@ typedef struct {
     float end;
 } pwm_piece_t;
 
+// Number of intervals in the RPM to PWM lookup table built by spindle_precompute_pwm_values().
+#ifndef SPINDLE_PWM_LUT_SIZE
+#define SPINDLE_PWM_LUT_SIZE 64
+#endif
+
 // Precalculated values that may be set/used by HAL driver to speed up RPM to PWM conversions if variable spindle is supported
 typedef struct {
     uint_fast16_t period;
@@ -56,6 +61,8 @@ typedef struct {
     bool always_on;
     uint_fast16_t n_pieces;
     pwm_piece_t piece[SPINDLE_NPWM_PIECES];
+    float lut_scale;                         // RPM to table position (8 bit fraction) factor, 0 if table is not valid
+    uint16_t lut[SPINDLE_PWM_LUT_SIZE + 1];  // Clamped and inverted (if enabled) PWM values for equidistant RPMs from rpm_min to rpm_max
 } spindle_pwm_t;
 
 // Used when HAL driver supports spindle synchronization
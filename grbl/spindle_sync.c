@@ -0,0 +1,225 @@
+/*
+  spindle_sync.c - spindle encoder interpolation and position tracking for spindle synchronized motion
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef ENABLE_SPINDLE_SYNC
+
+#include "hal.h"
+#include "pid.h"
+#include "spindle_sync.h"
+#ifdef PID_LOG
+#include "pid_log.h"
+#endif
+
+typedef struct {
+    bool enabled;
+    float pulse_distance;                   // Encoder pulse distance in fraction of one revolution
+    float rpm_factor;                       // RPM = rpm_factor / timer ticks per pulse
+    uint32_t maximum_tt;                    // Maximum timer ticks since last pulse before RPM = 0 is returned
+    uint32_t (*get_timestamp)(void);
+    volatile uint32_t sequence;             // Incremented before and after each update, odd while updating
+    volatile uint32_t pulse_count;          // Pulse count at last capture
+    volatile uint32_t timestamp;            // Timer value at last capture
+    volatile uint32_t tpp;                  // Timer ticks per pulse, 0 if unknown
+    volatile uint32_t pulse_count_index;    // Pulse count at last index pulse
+    volatile uint32_t index_count;
+    uint32_t pulse_count_reset;             // Pulse count at last data reset
+} spindle_encoder_t;
+
+typedef struct {
+    float block_start;              // Spindle position at start of move (mm)
+    float prev_pos;                 // Target position of previous segment (mm)
+    float steps_per_mm;             // Steps per mm for current block
+    float programmed_rate;          // Programmed feed in mm/rev for current block
+    uint32_t min_cycles_per_tick;   // Minimum cycles per tick for PID loop
+    pidf_t pid;                     // PID data for position
+} spindle_tracker_t;
+
+typedef struct {
+    uint32_t pulse_count;
+    uint32_t timestamp;
+    uint32_t tpp;
+    uint32_t pulse_count_index;
+    uint32_t index_count;
+} encoder_snapshot_t;
+
+static spindle_encoder_t encoder = {0};
+static spindle_tracker_t tracker;
+static encoder_snapshot_t isr_snapshot = {0}; // Last consistent copy of the encoder data read from interrupt context
+
+void spindle_sync_init (spindle_encoder_cfg_t *cfg)
+{
+    if((encoder.enabled = cfg->ppr > 0 && cfg->f_timer > 0 && cfg->get_timestamp != NULL)) {
+        encoder.pulse_distance = 1.0f / (float)cfg->ppr;
+        encoder.rpm_factor = 60.0f * (float)cfg->f_timer / (float)cfg->ppr;
+        encoder.maximum_tt = cfg->f_timer / 1000UL * SPINDLE_SYNC_STOPPED_MS;
+        encoder.get_timestamp = cfg->get_timestamp;
+        encoder.tpp = 0;
+    }
+
+    pidf_init(&tracker.pid, &settings.position.pid);
+    tracker.min_cycles_per_tick = hal.f_step_timer / 1000000UL * (settings.steppers.pulse_microseconds * 2 + settings.steppers.pulse_delay_microseconds);
+}
+
+ISR_CODE void spindle_encoder_capture (uint32_t pulse_count, uint32_t timestamp)
+{
+    uint32_t pulses = pulse_count - encoder.pulse_count, tt = timestamp - encoder.timestamp;
+
+    if(pulses) {
+        encoder.sequence++;
+        // Timer ticks per pulse is unknown after the spindle has been stopped.
+        encoder.tpp = tt > encoder.maximum_tt * pulses ? 0 : tt / pulses;
+        encoder.pulse_count = pulse_count;
+        encoder.timestamp = timestamp;
+        encoder.sequence++;
+    }
+}
+
+ISR_CODE void spindle_encoder_index (uint32_t pulse_count)
+{
+    encoder.sequence++;
+    encoder.index_count++;
+    encoder.pulse_count_index = pulse_count;
+    encoder.sequence++;
+}
+
+// Returns a consistent copy of the encoder data, retries if a capture interrupt updated the data while copying.
+// An interrupt handler may have preempted the update and cannot wait for it to complete, when called from
+// interrupt context the last consistent copy is returned instead.
+static inline void encoder_snapshot (encoder_snapshot_t *data, bool isr)
+{
+    uint32_t sequence;
+
+    do {
+        sequence = encoder.sequence;
+        data->pulse_count = encoder.pulse_count;
+        data->timestamp = encoder.timestamp;
+        data->tpp = encoder.tpp;
+        data->pulse_count_index = encoder.pulse_count_index;
+        data->index_count = encoder.index_count;
+        if(!(sequence & 1) && sequence == encoder.sequence) {
+            if(isr)
+                isr_snapshot = *data;
+            return;
+        }
+    } while(!isr);
+
+    *data = isr_snapshot;
+}
+
+// Spindle position in number of revolutions since last reset, interpolated between encoder pulses
+// by the time since the last pulse relative to the last pulse interval.
+static float angular_position (encoder_snapshot_t *data, uint32_t tt)
+{
+    float fraction = 0.0f;
+
+    if(data->tpp)
+        fraction = tt >= data->tpp ? 1.0f : (float)tt / (float)data->tpp;
+
+    // NOTE: The index pulse may be registered after the last capture, the pulse count difference is then negative.
+    return (float)data->index_count + ((float)(int32_t)(data->pulse_count - data->pulse_count_index) + fraction) * encoder.pulse_distance;
+}
+
+spindle_data_t *spindle_sync_get_data (spindle_data_t *data, spindle_data_request_t request)
+{
+    if(!encoder.enabled)
+        return data;
+
+    encoder_snapshot_t enc;
+    encoder_snapshot(&enc, false);
+
+    uint32_t tt = encoder.get_timestamp() - enc.timestamp;
+
+    switch(request) {
+
+        case SpindleData_Counters:
+            data->index_count = enc.index_count;
+            data->pulse_count = enc.pulse_count - encoder.pulse_count_reset;
+            break;
+
+        case SpindleData_RPM:
+            data->rpm = enc.tpp == 0 || tt > encoder.maximum_tt ? 0.0f : encoder.rpm_factor / (float)enc.tpp;
+            break;
+
+        case SpindleData_AngularPosition:
+            data->angular_position = angular_position(&enc, tt);
+            break;
+    }
+
+    return data;
+}
+
+void spindle_sync_reset_data (spindle_data_t *data)
+{
+    // Capture interrupts also update the data, block them while resetting.
+    hal.irq_disable();
+    encoder.sequence++;
+    encoder.pulse_count_reset = encoder.pulse_count_index = encoder.pulse_count;
+    encoder.index_count = 0;
+    encoder.sequence++;
+    hal.irq_enable();
+
+    data->pulse_count = data->index_count = 0;
+    data->angular_position = 0.0f;
+}
+
+// Closes the position loop once per segment. Segments are of fixed duration in the cruising part
+// of the motion, giving a fixed PID sample rate. The position error at the start of the segment is
+// corrected by adjusting the segment step rate before it is loaded into the step timer.
+ISR_CODE void spindle_sync_segment (segment_t *segment, bool new_block)
+{
+    if(!encoder.enabled)
+        return;
+
+    encoder_snapshot_t enc;
+    encoder_snapshot(&enc, true);
+
+    float position = angular_position(&enc, encoder.get_timestamp() - enc.timestamp);
+
+    if(new_block) {
+        tracker.programmed_rate = segment->exec_block->programmed_rate;
+        tracker.steps_per_mm = segment->exec_block->steps_per_mm;
+        tracker.block_start = position * tracker.programmed_rate;
+        tracker.prev_pos = 0.0f;
+        pidf_reset(&tracker.pid);
+#ifdef PID_LOG
+        // Setpoint, actual position and step correction per segment. Continues a running capture.
+        pid_log_start(3, (float)(segment->cycles_per_tick * segment->n_step) / (float)hal.f_step_timer, 0);
+#endif
+    } else if(segment->cruising && segment->n_step) {
+
+        float rate = (float)hal.f_step_timer / (float)(segment->cycles_per_tick * segment->n_step);
+        float actual_pos = position * tracker.programmed_rate - tracker.block_start;
+        float step_delta = pidf(&tracker.pid, tracker.prev_pos, actual_pos, rate) * tracker.steps_per_mm;
+        float ticks = (float)segment->cycles_per_tick * (1.0f + step_delta / (float)segment->n_step);
+
+        segment->cycles_per_tick = ticks < (float)tracker.min_cycles_per_tick ? tracker.min_cycles_per_tick : (uint32_t)ticks;
+
+#ifdef PID_LOG
+        pid_log_sample(3, (float[]){ tracker.prev_pos, actual_pos, step_delta });
+#endif
+    }
+
+    tracker.prev_pos = segment->target_position;
+}
+
+#endif
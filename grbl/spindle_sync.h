@@ -0,0 +1,57 @@
+/*
+  spindle_sync.h - spindle encoder interpolation and position tracking for spindle synchronized motion
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SPINDLE_SYNC_H_
+#define _SPINDLE_SYNC_H_
+
+#include "stepper.h"
+#include "spindle_control.h"
+
+#ifndef SPINDLE_SYNC_STOPPED_MS
+#define SPINDLE_SYNC_STOPPED_MS 250 // Time since last encoder pulse before the spindle is considered stopped
+#endif
+
+// Encoder configuration, provided by the driver.
+typedef struct {
+    uint32_t ppr;                       // Encoder pulses per revolution
+    uint32_t f_timer;                   // Frequency of the capture timer (Hz)
+    uint32_t (*get_timestamp)(void);    // Returns the current capture timer value, must be counting up and wrap at 32 bits
+} spindle_encoder_cfg_t;
+
+// Call from driver settings_changed handler, a ppr of 0 disables the module.
+void spindle_sync_init (spindle_encoder_cfg_t *encoder);
+
+// Call from encoder capture interrupt with the free running pulse count and the timer value captured at the last pulse.
+void spindle_encoder_capture (uint32_t pulse_count, uint32_t timestamp);
+
+// Call from encoder index pulse interrupt with the free running pulse count at the index pulse.
+void spindle_encoder_index (uint32_t pulse_count);
+
+// Updates counters, RPM and angular position in the driver spindle data, for use by hal.spindle_get_data implementations.
+spindle_data_t *spindle_sync_get_data (spindle_data_t *data, spindle_data_request_t request);
+
+// Resets counters and position, for use by hal.spindle_reset_data implementations.
+void spindle_sync_reset_data (spindle_data_t *data);
+
+// Called by the stepper ISR when a spindle synchronized segment is loaded.
+void spindle_sync_segment (segment_t *segment, bool new_block);
+
+#endif
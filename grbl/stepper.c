@@ -27,6 +27,9 @@
 
 #include "hal.h"
 #include "protocol.h"
+#ifdef ENABLE_SPINDLE_SYNC
+#include "spindle_sync.h"
+#endif
 
 //#include "debug.h"
 
@@ -73,6 +76,59 @@ static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
 static stepper_t st;
 
+#ifdef ENABLE_LASER_RASTER
+
+#ifndef SPINDLE_PWM_DIRECT
+#error "Laser raster requires direct PWM control of the spindle!"
+#endif
+
+// Running data for raster lines, pixels are advanced with a Bresenham like counter
+// so the power changes at the exact step position where the next pixel starts.
+typedef struct {
+    raster_data_t *data;
+    uint_fast16_t pixel;
+    uint_fast16_t pwm;
+    uint32_t counter;
+    uint32_t increment;
+} st_raster_t;
+
+static st_raster_t raster;
+#endif
+
+#ifdef ENABLE_BACKLASH_COMPENSATION
+
+// Backlash take-up data. Slack is tracked per axis as the motor position within the backlash, from 0
+// when taken up in the negative direction to the backlash steps when taken up in the positive direction.
+// Take-up steps are output by the stepper ISR without updating the machine position.
+typedef struct {
+    axes_signals_t pending;     // Axes with take-up steps to be output
+    uint32_t steps[N_AXIS];     // Backlash in steps
+    uint32_t slack[N_AXIS];     // Motor position within the backlash
+    uint32_t take_up[N_AXIS];   // Take-up steps required at start of current block
+    uint32_t remaining[N_AXIS]; // Take-up steps not yet output
+    uint32_t increment[N_AXIS]; // Counter increment per interrupt tick, scaled by AMASS level
+    uint32_t counter[N_AXIS];   // Bresenham like counter for distributing take-up steps
+} st_backlash_t;
+
+static st_backlash_t backlash = {0};
+#endif
+
+#ifdef ENABLE_LASER_STEP_PWM
+
+#ifndef SPINDLE_PWM_DIRECT
+#error "Laser step PWM requires direct PWM control of the spindle!"
+#endif
+
+// Running data for laser power interpolated from segment start to end speed.
+typedef struct {
+    uint32_t acc;           // Current PWM value, 16.16 fixed point
+    int32_t increment;      // PWM change per interrupt tick, 16.16 fixed point
+    uint_fast16_t value;    // PWM value last output
+} st_laser_pwm_t;
+
+static st_laser_pwm_t laser_pwm;
+#endif
+
 #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
 typedef struct {
     uint32_t level_1;
@@ -188,6 +244,103 @@ void st_wake_up ()
 }
 
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+
+void st_backlash_init (uint32_t *steps, axes_signals_t negative)
+{
+    uint_fast8_t idx = N_AXIS;
+
+    backlash.pending.mask = 0;
+
+    do {
+        idx--;
+        backlash.steps[idx] = steps[idx];
+        backlash.slack[idx] = (negative.mask & bit(idx)) ? 0 : steps[idx];
+    } while(idx);
+}
+
+// Calculate take-up steps for axes moving in the opposite direction of the current slack.
+ISR_CODE static void backlash_block_start (void)
+{
+    uint_fast8_t idx = N_AXIS;
+
+    backlash.pending.mask = 0;
+
+    do {
+        idx--;
+        if(backlash.steps[idx] && st.exec_block->steps[idx]) {
+            backlash.take_up[idx] = backlash.remaining[idx] = (st.dir_outbits.mask & bit(idx))
+                                                               ? backlash.slack[idx]
+                                                               : backlash.steps[idx] - backlash.slack[idx];
+            if(backlash.remaining[idx]) {
+                backlash.counter[idx] = 0;
+                backlash.pending.mask |= bit(idx);
+            }
+        }
+    } while(idx);
+}
+
+ISR_CODE static void backlash_segment_start (void)
+{
+    uint_fast8_t idx = N_AXIS;
+
+    do {
+        idx--;
+      #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+        backlash.increment[idx] = backlash.take_up[idx] << (MAX_AMASS_LEVEL - st.amass_level);
+      #else
+        backlash.increment[idx] = backlash.take_up[idx];
+      #endif
+    } while(idx);
+}
+
+// Returns take-up steps to output, distributed over the backlash spread of the block.
+// A step is deferred to the next interrupt tick if the axis is already stepping.
+ISR_CODE static inline uint8_t backlash_inject (uint8_t step_outbits)
+{
+    uint_fast8_t idx = N_AXIS;
+    uint8_t take_up = 0;
+    uint32_t spread = st.exec_block->backlash_spread;
+
+    do {
+        idx--;
+        if(backlash.pending.mask & bit(idx)) {
+            if(backlash.counter[idx] < spread)
+                backlash.counter[idx] += backlash.increment[idx];
+            if(backlash.counter[idx] >= spread && !(step_outbits & bit(idx))) {
+                backlash.counter[idx] -= spread;
+                take_up |= bit(idx);
+                if(st.dir_outbits.mask & bit(idx))
+                    backlash.slack[idx]--;
+                else
+                    backlash.slack[idx]++;
+                if(--backlash.remaining[idx] == 0)
+                    backlash.pending.mask &= ~bit(idx);
+            }
+        }
+    } while(idx);
+
+    return take_up;
+}
+
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+
+// Convert pixel power to PWM value, integer only as called from the stepper ISR.
+ISR_CODE static inline uint_fast16_t raster_pwm (st_block_t *block, uint8_t power)
+{
+    return power == 0 ? block->raster_pwm_off : (uint_fast16_t)((int32_t)block->raster_pwm_min + (block->raster_pwm_delta * (int32_t)power) / 255);
+}
+
+ISR_CODE static inline void raster_set_pwm (uint_fast16_t pwm)
+{
+    if(pwm != raster.pwm)
+        hal.spindle_update_pwm(raster.pwm = pwm);
+}
+
+#endif
+
 // Stepper shutdown
 ISR_CODE void st_go_idle ()
 {
@@ -253,10 +406,6 @@ ISR_CODE void st_go_idle ()
 */
 ISR_CODE void stepper_driver_interrupt_handler (void)
 {
-#ifdef ENABLE_BACKLASH_COMPENSATION
-    static bool backlash_motion;
-#endif
-
     // Start a step pulse when there is a block to execute.
     if(st.exec_block) {
 
@@ -264,8 +413,17 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
 
         st.new_block = st.dir_change = false;
 
-        if (st.step_count == 0) // Segment is complete. Discard current segment.
+        if (st.step_count == 0) { // Segment is complete. Discard current segment.
+#ifdef ENABLE_LASER_RASTER
+            // Return raster data to the planner pool as soon as the raster line is completed.
+            if(st.exec_segment && st.exec_segment->release_raster) {
+                plan_free_raster(st.exec_block->raster);
+                st.exec_block->raster = NULL;
+                raster.data = NULL;
+            }
+#endif
             st.exec_segment = NULL;
+        }
     }
 
     // If there is no step segment, attempt to pop one from the stepper buffer
@@ -276,6 +434,12 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
             // Initialize new step segment and load number of steps to execute
             st.exec_segment = (segment_t *)segment_buffer_tail;
 
+#ifdef ENABLE_SPINDLE_SYNC
+            // Correct segment step rate for spindle position error.
+            if(st.exec_segment->spindle_sync)
+                spindle_sync_segment(st.exec_segment, st.exec_block != st.exec_segment->exec_block);
+#endif
+
             // Initialize step segment timing per step and load number of steps to execute.
             hal.stepper_cycles_per_tick(st.exec_segment->cycles_per_tick);
             st.step_count = st.exec_segment->n_step; // NOTE: Can sometimes be zero when moving slow.
@@ -289,13 +453,17 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
                 st.step_event_count = st.exec_block->step_event_count;
                 st.new_block = true;
 #ifdef ENABLE_BACKLASH_COMPENSATION
-                backlash_motion = st.exec_block->backlash_motion;
+                backlash_block_start();
 #endif
 
                 if(st.exec_block->overrides.sync)
                     sys.override.control = st.exec_block->overrides;
 
-                // Execute output commands to be syncronized with motion
+                // Queued probing motion (multi-point probing), start monitoring the probe.
+                if(st.exec_block->probe_motion)
+                    sys_probing_state = Probing_Active;
+
+                // Execute output commands to be syncronized with motion and release them to the planner pool
                 while(st.exec_block->output_commands) {
                     output_command_t *cmd = st.exec_block->output_commands;
                     cmd->is_executed = true;
@@ -303,7 +471,7 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
                         hal.port.digital_out(cmd->port, cmd->value != 0.0f);
                     else
                         hal.port.analog_out(cmd->port, cmd->value);
-                    st.exec_block->output_commands = cmd->next;
+                    st.exec_block->output_commands = plan_free_output_command(cmd);
                 }
 
                 // "Enqueue" any message to be displayed (by foreground process)
@@ -312,6 +480,15 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
                     st.exec_block->message = NULL;
                 }
 
+#ifdef ENABLE_LASER_RASTER
+                // Start raster line with the power of the first pixel.
+                if((raster.data = st.exec_block->raster)) {
+                    raster.pixel = 0;
+                    raster.counter = 0;
+                    hal.spindle_update_pwm(raster.pwm = raster_pwm(st.exec_block, raster.data->power[0]));
+                }
+#endif
+
                 // Initialize Bresenham line and distance counters
                 st.counter_x = st.counter_y = st.counter_z
                 #ifdef A_AXIS
@@ -347,6 +524,27 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
            #endif
          #endif
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+            if(backlash.pending.mask)
+                backlash_segment_start();
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+            // Pixel progress per interrupt tick, scaled by AMASS level.
+          #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+            if(raster.data)
+                raster.increment = raster.data->length << (MAX_AMASS_LEVEL - st.amass_level);
+          #else
+            if(raster.data)
+                raster.increment = raster.data->length;
+          #endif
+#endif
+
+#ifdef ENABLE_LASER_STEP_PWM
+            if((laser_pwm.increment = st.exec_segment->update_rpm ? st.exec_segment->spindle_pwm_increment : 0))
+                laser_pwm.acc = (uint32_t)(laser_pwm.value = st.exec_segment->spindle_pwm) << 16;
+#endif
+
             if(st.exec_segment->update_rpm) {
               #ifdef SPINDLE_PWM_DIRECT
                 hal.spindle_update_pwm(st.exec_segment->spindle_pwm);
@@ -384,9 +582,6 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
     if (st.counter_x > st.step_event_count) {
         step_outbits.x = On;
         st.counter_x -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
             sys_position[X_AXIS] = sys_position[X_AXIS] + (st.dir_outbits.x ? -1 : 1);
     }
 
@@ -394,9 +589,6 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
     if (st.counter_y > st.step_event_count) {
         step_outbits.y = On;
         st.counter_y -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
             sys_position[Y_AXIS] = sys_position[Y_AXIS] + (st.dir_outbits.y ? -1 : 1);
     }
 
@@ -404,9 +596,6 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
     if (st.counter_z > st.step_event_count) {
         step_outbits.z = On;
         st.counter_z -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
             sys_position[Z_AXIS] = sys_position[Z_AXIS] + (st.dir_outbits.z ? -1 : 1);
     }
 
@@ -415,9 +604,6 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
       if (st.counter_a > st.step_event_count) {
           step_outbits.a = On;
           st.counter_a -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
               sys_position[A_AXIS] = sys_position[A_AXIS] + (st.dir_outbits.a ? -1 : 1);
       }
   #endif
@@ -427,9 +613,6 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
       if (st.counter_b > st.step_event_count) {
           step_outbits.b = On;
           st.counter_b -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
               sys_position[B_AXIS] = sys_position[B_AXIS] + (st.dir_outbits.b ? -1 : 1);
       }
   #endif
@@ -439,15 +622,38 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
       if (st.counter_c > st.step_event_count) {
           step_outbits.c = On;
           st.counter_c -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
               sys_position[C_AXIS] = sys_position[C_AXIS] + (st.dir_outbits.c ? -1 : 1);
       }
   #endif
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+    if(backlash.pending.mask && sys.state != STATE_HOMING)
+        step_outbits.mask |= backlash_inject(step_outbits.mask);
+#endif
+
     st.step_outbits.value = step_outbits.value;
 
+#ifdef ENABLE_LASER_RASTER
+    // Advance to next pixel(s) when its start position is reached.
+    if(raster.data && (raster.counter += raster.increment) >= st.step_event_count) {
+        do {
+            raster.counter -= st.step_event_count;
+            raster.pixel++;
+        } while(raster.counter >= st.step_event_count);
+        if(raster.pixel < raster.data->length)
+            raster_set_pwm(raster_pwm(st.exec_block, raster.data->power[raster.pixel]));
+    }
+#endif
+
+#ifdef ENABLE_LASER_STEP_PWM
+    // Ramp laser power towards the power for the segment end speed.
+    if(laser_pwm.increment) {
+        uint_fast16_t pwm = (uint_fast16_t)((laser_pwm.acc += (uint32_t)laser_pwm.increment) >> 16);
+        if(pwm != laser_pwm.value)
+            hal.spindle_update_pwm(laser_pwm.value = pwm);
+    }
+#endif
+
     // During a homing cycle, lock out and prevent desired axes from moving.
     if (sys.state == STATE_HOMING)
         st.step_outbits.value &= sys.homing_axis_lock.mask;
@@ -471,8 +677,17 @@ void st_reset ()
     // NOTE: buffer indices starts from 1 for simpler driver coding!
 
     // Set up stepper block ringbuffer as circular linked list and add id
+    // Release any messages and output commands from prepped blocks not executed.
     uint_fast8_t idx;
     for(idx = 0 ; idx <= SEGMENT_BUFFER_SIZE - 2 ; idx++) {
+        plan_free_message(st_block_buffer[idx].message);
+        st_block_buffer[idx].message = NULL;
+        while(st_block_buffer[idx].output_commands)
+            st_block_buffer[idx].output_commands = plan_free_output_command(st_block_buffer[idx].output_commands);
+#ifdef ENABLE_LASER_RASTER
+        plan_free_raster(st_block_buffer[idx].raster);
+        st_block_buffer[idx].raster = NULL;
+#endif
         st_block_buffer[idx].next = &st_block_buffer[idx == SEGMENT_BUFFER_SIZE - 2 ? 0 : idx + 1];
         st_block_buffer[idx].id = idx + 1;
     }
@@ -493,6 +708,17 @@ void st_reset ()
 
     memset(&prep, 0, sizeof(st_prep_t));
     memset(&st, 0, sizeof(stepper_t));
+#ifdef ENABLE_LASER_STEP_PWM
+    memset(&laser_pwm, 0, sizeof(st_laser_pwm_t));
+#endif
+
+#ifdef ENABLE_BACKLASH_COMPENSATION
+    backlash.pending.mask = 0; // Slack is kept, it reflects the physical state.
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+    memset(&raster, 0, sizeof(st_raster_t));
+#endif
 
 #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
     // TODO: move to driver?
@@ -523,6 +749,22 @@ void st_update_plan_block_parameters ()
     }
 }
 
+// Notify subscriber of the steps per axis queued by a new segment. Steps are derived from the step
+// events executed by the block before and after the segment so they sum up to the block steps.
+static void segment_prepared (uint32_t steps_remaining, uint32_t n_steps_remaining)
+{
+    uint_fast8_t idx = N_AXIS;
+    uint32_t steps[N_AXIS];
+    uint64_t start = pl_block->step_event_count - steps_remaining, end = pl_block->step_event_count - n_steps_remaining;
+
+    do {
+        idx--;
+        steps[idx] = (uint32_t)((pl_block->steps[idx] * end) / pl_block->step_event_count - (pl_block->steps[idx] * start) / pl_block->step_event_count);
+    } while(idx);
+
+    grbl.on_segment_prepared(steps);
+}
+
 // Changes the run state of the step segment buffer to execute the special parking motion.
 void st_parking_setup_buffer()
 {
@@ -606,6 +848,15 @@ void st_prep_buffer()
 
                 st_prep_block = st_prep_block->next;
 
+#ifdef ENABLE_LASER_RASTER
+                // Release raster data of the block previously using this slot if not released on completion,
+                // e.g. when the block was ended by a feed hold.
+                if(st_prep_block->raster) {
+                    plan_free_raster(st_prep_block->raster);
+                    st_prep_block->raster = NULL;
+                }
+#endif
+
                 uint_fast8_t idx = N_AXIS;
               #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
                 do {
@@ -627,16 +878,41 @@ void st_prep_buffer()
                 st_prep_block->direction_bits = pl_block->direction_bits;
                 st_prep_block->programmed_rate = pl_block->programmed_rate;
                 st_prep_block->millimeters = pl_block->millimeters;
-                st_prep_block->steps_per_mm = (float)pl_block->step_event_count / pl_block->millimeters;
+                st_prep_block->steps_per_mm = pl_block->condition.dwell ? 0.0f : (float)pl_block->step_event_count / pl_block->millimeters;
+                // Hand over message and output commands, released by the stepper ISR or st_reset() from now on.
                 st_prep_block->message = pl_block->message;
                 st_prep_block->output_commands = pl_block->output_commands;
+                pl_block->message = NULL;
+                pl_block->output_commands = NULL;
+#ifdef ENABLE_LASER_RASTER
+                if((st_prep_block->raster = pl_block->raster)) {
+                    // Precompute PWM range for pixel power, from lowest power to programmed power with overrides applied.
+                    float rpm = spindle_set_rpm(pl_block->spindle.rpm, sys.override.spindle_rpm);
+                    st_prep_block->raster_pwm_off = hal.spindle_get_pwm(0.0f);
+                    st_prep_block->raster_pwm_min = hal.spindle_get_pwm(settings.spindle.rpm_min > 0.0f ? settings.spindle.rpm_min : 0.001f);
+                    st_prep_block->raster_pwm_delta = (int32_t)hal.spindle_get_pwm(rpm) - (int32_t)st_prep_block->raster_pwm_min;
+                    if(!pl_block->condition.spindle.on) {
+                        st_prep_block->raster_pwm_min = st_prep_block->raster_pwm_off;
+                        st_prep_block->raster_pwm_delta = 0;
+                    }
+                    pl_block->raster = NULL;
+                }
+#endif
                 st_prep_block->overrides = pl_block->overrides;
-                st_prep_block->backlash_motion = pl_block->condition.backlash_motion;
+                st_prep_block->probe_motion = pl_block->condition.probe_motion;
+#ifdef ENABLE_BACKLASH_COMPENSATION
+                // Backlash take-up steps after a direction reversal are spread over the start of the block.
+                st_prep_block->backlash_spread = pl_block->millimeters > BACKLASH_TAKEUP_DISTANCE
+                                                  ? (uint32_t)((float)st_prep_block->step_event_count * (BACKLASH_TAKEUP_DISTANCE / pl_block->millimeters))
+                                                  : st_prep_block->step_event_count;
+                if(st_prep_block->backlash_spread == 0)
+                    st_prep_block->backlash_spread = 1;
+#endif
 
                 // Initialize segment buffer data for generating the segments.
                 prep.steps_per_mm = st_prep_block->steps_per_mm;
                 prep.steps_remaining = pl_block->step_event_count;
-                prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.steps_per_mm;
+                prep.req_mm_increment = pl_block->condition.dwell ? 0.0f : REQ_MM_INCREMENT_SCALAR / prep.steps_per_mm;
                 prep.dt_remainder = prep.target_position = 0.0f; // Reset for new segment block
 
                 if (sys.step_control.execute_hold || prep.recalculate.decel_override) {
@@ -651,9 +927,14 @@ void st_prep_buffer()
                 // spindle off.
                 if ((st_prep_block->dynamic_rpm = pl_block->condition.is_rpm_rate_adjusted))
                     // Pre-compute inverse programmed rate to speed up RPM updating per step segment.
-                    prep.inv_feedrate = pl_block->condition.is_laser_ppi_mode ? 1.0f : 1.0f / pl_block->programmed_rate;
+                    prep.inv_feedrate = pl_block->condition.is_laser_ppi_mode || pl_block->condition.dwell ? 1.0f : 1.0f / pl_block->programmed_rate;
                 else
                     st_prep_block->dynamic_rpm = pl_block->condition.is_rpm_pos_adjusted;
+#ifdef ENABLE_LASER_RASTER
+                // Power is controlled by the stepper ISR for raster lines, turn laser off when motion ends.
+                if(st_prep_block->raster)
+                    st_prep_block->dynamic_rpm = true;
+#endif
             }
 
             /* ---------------------------------------------------------------------------------
@@ -753,12 +1034,80 @@ void st_prep_buffer()
                 sys.step_control.update_spindle_rpm |= settings.flags.laser_mode; // Force update whenever updating block in laser mode.
         }
 
+        // Timed dwell: generate segments without steps until the dwell time has elapsed.
+        if(pl_block->condition.dwell) {
+
+            if(sys.step_control.execute_hold) {
+                // Nothing to decelerate, end the hold here. The remaining dwell time is executed on resume.
+                sys.step_control.end_motion = On;
+                if (settings.parking.flags.enabled && !prep.recalculate.parking)
+                    prep.recalculate.hold_partial_block = On;
+                return; // Bail!
+            }
+
+            segment_t *prep_segment = segment_buffer_head;
+            float dt = pl_block->dwell > DT_SEGMENT ? DT_SEGMENT : pl_block->dwell;
+
+            prep_segment->exec_block = st_prep_block;
+            prep_segment->update_rpm = false;
+            prep_segment->spindle_sync = false;
+#ifdef ENABLE_LASER_RASTER
+            prep_segment->release_raster = false;
+#endif
+#ifdef ENABLE_LASER_STEP_PWM
+            prep_segment->spindle_pwm_increment = 0;
+#endif
+
+            // Laser is kept on at programmed power in constant power mode, off in dynamic power mode.
+            if(sys.step_control.update_spindle_rpm) {
+                float rpm = 0.0f;
+                if(pl_block->condition.spindle.on && !(pl_block->condition.is_rpm_rate_adjusted && !pl_block->condition.is_laser_ppi_mode))
+                    rpm = spindle_set_rpm(pl_block->spindle.rpm, sys.override.spindle_rpm);
+                else
+                    sys.spindle_rpm = 0.0f;
+                if(rpm != prep.current_spindle_rpm) {
+                    prep.current_spindle_rpm = rpm;
+                  #ifdef SPINDLE_PWM_DIRECT
+                    prep_segment->spindle_pwm = hal.spindle_get_pwm(rpm);
+                  #else
+                    prep_segment->spindle_rpm = rpm;
+                  #endif
+                    prep_segment->update_rpm = true;
+                }
+                sys.step_control.update_spindle_rpm = Off;
+            }
+
+            // Empty step events at approximately 1 ms intervals.
+            prep_segment->n_step = (uint_fast16_t)ceilf(dt * 60000.0f);
+            prep_segment->cycles_per_tick = (uint32_t)ceilf(cycles_per_min * dt / (float)prep_segment->n_step);
+            prep_segment->amass_level = 0;
+            prep_segment->current_rate = prep.current_speed = 0.0f;
+
+            // Segment complete! Increment segment pointers, so stepper ISR can immediately execute it.
+            segment_buffer_head = segment_next_head;
+            segment_next_head = segment_next_head->next;
+
+            if((pl_block->dwell -= dt) <= 0.0f) {
+                pl_block = NULL; // Set pointer to indicate check and load next planner block.
+                plan_discard_current_block();
+            }
+
+            continue;
+        }
+
         // Initialize new segment
         segment_t *prep_segment = segment_buffer_head;
 
         // Set new segment to point to the current segment data block.
         prep_segment->exec_block = st_prep_block;
         prep_segment->update_rpm = false;
+#ifdef ENABLE_LASER_STEP_PWM
+        prep_segment->spindle_pwm_increment = 0;
+
+        float entry_speed = prep.current_speed; // Segment start speed, used for laser power interpolation.
+        bool ramp_pwm = false;
+        uint_fast16_t exit_pwm = 0;
+#endif
 
         /*------------------------------------------------------------------------------------
             Compute the average velocity of this new segment by determining the total distance
@@ -869,6 +1218,11 @@ void st_prep_buffer()
            Compute spindle spindle speed for step segment
         */
 
+#ifdef ENABLE_LASER_RASTER
+        if (st_prep_block->raster)
+            prep.current_spindle_rpm = -1.0f; // Power is set per pixel, force update for next block.
+        else
+#endif
         if (sys.step_control.update_spindle_rpm || st_prep_block->dynamic_rpm) {
             float rpm;
             if (pl_block->condition.spindle.on) {
@@ -890,6 +1244,16 @@ void st_prep_buffer()
               #ifdef SPINDLE_PWM_DIRECT
                 prep.current_spindle_rpm = rpm;
                 prep_segment->spindle_pwm = hal.spindle_get_pwm(rpm);
+               #ifdef ENABLE_LASER_STEP_PWM
+                // Start segment at the power for the entry speed, the ISR ramps it to the exit speed power.
+                // The ramp increment is calculated below when the number of interrupt ticks is known.
+                if(pl_block->condition.spindle.on && pl_block->condition.is_rpm_rate_adjusted &&
+                    !(pl_block->condition.is_laser_ppi_mode || pl_block->condition.is_rpm_pos_adjusted) && entry_speed != prep.current_speed) {
+                    ramp_pwm = true;
+                    exit_pwm = prep_segment->spindle_pwm;
+                    prep_segment->spindle_pwm = hal.spindle_get_pwm(spindle_set_rpm(pl_block->spindle.rpm * entry_speed * prep.inv_feedrate, sys.override.spindle_rpm));
+                }
+               #endif
               #else
                 prep.current_spindle_rpm = prep_segment->spindle_rpm = rpm;
               #endif
@@ -959,10 +1323,22 @@ void st_prep_buffer()
         prep_segment->cycles_per_tick = cycles;
         prep_segment->current_rate = prep.current_speed;
 
+#ifdef ENABLE_LASER_STEP_PWM
+        if(ramp_pwm && exit_pwm != prep_segment->spindle_pwm && prep_segment->n_step)
+            prep_segment->spindle_pwm_increment = (int32_t)(((float)exit_pwm - (float)prep_segment->spindle_pwm) * 65536.0f / (float)prep_segment->n_step);
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+        prep_segment->release_raster = st_prep_block->raster && mm_remaining <= 0.0f;
+#endif
+
         // Segment complete! Increment segment pointers, so stepper ISR can immediately execute it.
         segment_buffer_head = segment_next_head;
         segment_next_head = segment_next_head->next;
 
+        if(grbl.on_segment_prepared)
+            segment_prepared(prep.steps_remaining, n_steps_remaining);
+
         // Update the appropriate planner and segment data.
         pl_block->millimeters = mm_remaining;
         prep.steps_remaining = n_steps_remaining;
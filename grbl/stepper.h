@@ -53,7 +53,16 @@ typedef struct st_block {
     char *message;                     // Message to be displayed when block is executed
     output_command_t *output_commands; // Output commands (linked list) to be performed when block is executed
     bool dynamic_rpm;                  // Tracks motions that require dynamic RPM adjustment
-    bool backlash_motion;
+    bool probe_motion;                 // Arms the probe monitor when block execution starts
+#ifdef ENABLE_BACKLASH_COMPENSATION
+    uint32_t backlash_spread;          // Number of step events to spread backlash take-up steps over
+#endif
+#ifdef ENABLE_LASER_RASTER
+    raster_data_t *raster;             // Laser power per pixel, applied by the stepper ISR
+    uint_fast16_t raster_pwm_min;      // PWM value for lowest non-zero pixel power
+    int32_t raster_pwm_delta;          // PWM value range from lowest to full (programmed) pixel power
+    uint_fast16_t raster_pwm_off;      // PWM value for zero pixel power
+#endif
 } st_block_t;
 
 typedef struct st_segment {
@@ -66,12 +75,18 @@ typedef struct st_segment {
     uint_fast16_t n_step;           // Number of step events to be executed for this segment
 #ifdef SPINDLE_PWM_DIRECT
     uint_fast16_t spindle_pwm;      // Spindle PWM to be set at the start of segment execution
+#ifdef ENABLE_LASER_STEP_PWM
+    int32_t spindle_pwm_increment;  // Laser PWM change per interrupt tick, 16.16 fixed point
+#endif
 #else
     float spindle_rpm;              // Spindle RPM to be set at the start of the segment execution
 #endif
     bool update_rpm;                // True if set spindle speed at the start of the segment execution
     bool spindle_sync;              // True if block is spindle synchronized
     bool cruising;                  // True when in cruising part of profile, only set for spindle synced moves
+#ifdef ENABLE_LASER_RASTER
+    bool release_raster;            // True if last segment of a raster line, raster data is released when completed
+#endif
     uint_fast8_t amass_level;       // Indicates AMASS level for the ISR to execute this segment
 } segment_t;
 
@@ -134,6 +149,11 @@ void st_update_plan_block_parameters();
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+#ifdef ENABLE_BACKLASH_COMPENSATION
+// Set backlash in steps per axis and the axes where slack is taken up in the negative direction.
+void st_backlash_init (uint32_t *steps, axes_signals_t negative);
+#endif
+
 void stepper_driver_interrupt_handler (void);
 
 #endif
@@ -0,0 +1,135 @@
+/*
+  stream.c - output stream fan-out
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "hal.h"
+
+typedef struct {
+    const stream_output_t *output;
+    uint32_t last_report;   // time of last realtime report written to the output
+    uint32_t dropped;       // number of lines dropped due to a full transmit buffer
+    bool write_line;        // current line is written to the output
+} fanout_output_t;
+
+typedef struct {
+    uint_fast8_t n_outputs;
+    bool is_report;         // current line is a realtime report
+    bool line_started;      // part of current line has already been dispatched
+    uint_fast16_t length;
+    char data[STREAM_FANOUT_LINE_SIZE];
+    fanout_output_t output[STREAM_FANOUT_MAX_OUTPUTS];
+} fanout_t;
+
+static fanout_t fanout = {0};
+
+// Register an output for hal.stream.write_all() fan-out.
+// NOTE: the output structure must be kept in scope (static or const) by the caller.
+bool stream_fanout_register (const stream_output_t *output)
+{
+    bool ok;
+
+    if((ok = fanout.n_outputs < STREAM_FANOUT_MAX_OUTPUTS && output->write != NULL)) {
+        memset(&fanout.output[fanout.n_outputs], 0, sizeof(fanout_output_t));
+        fanout.output[fanout.n_outputs++].output = output;
+    }
+
+    return ok;
+}
+
+// Returns number of lines dropped for output due to full transmit buffer.
+uint32_t stream_fanout_get_dropped (stream_type_t type)
+{
+    uint_fast8_t idx = fanout.n_outputs;
+
+    while(idx) {
+        if(fanout.output[--idx].output->type == type)
+            return fanout.output[idx].dropped;
+    }
+
+    return 0;
+}
+
+// Decide if the output should receive the line that is about to be dispatched.
+static bool output_accept (fanout_output_t *entry)
+{
+    uint32_t ms = 0;
+    const stream_output_t *output = entry->output;
+    bool active = output->type == hal.stream.type;
+
+    if(output->is_connected && !output->is_connected())
+        return false;
+
+    // Rate limit realtime reports to secondary outputs.
+    if(fanout.is_report && !active && output->report_interval && hal.get_elapsed_ticks) {
+        if(((ms = hal.get_elapsed_ticks()) - entry->last_report) < output->report_interval)
+            return false;
+    }
+
+    // Blocking write if output buffer state cannot be determined or when the line must not be dropped.
+    if(output->get_tx_buffer_free && (fanout.is_report || (!active && output->drop_policy == FanoutDrop_All))) {
+        if(output->get_tx_buffer_free() < fanout.length) {
+            entry->dropped++;
+            return false;
+        }
+    }
+
+    if(ms)
+        entry->last_report = ms;
+
+    return true;
+}
+
+static void fanout_dispatch (bool eol)
+{
+    uint_fast8_t idx;
+
+    fanout.data[fanout.length] = '\0';
+
+    if(!fanout.line_started)
+        fanout.is_report = fanout.data[0] == '<';
+
+    for(idx = 0; idx < fanout.n_outputs; idx++) {
+        if(!fanout.line_started)
+            fanout.output[idx].write_line = output_accept(&fanout.output[idx]);
+        if(fanout.output[idx].write_line)
+            fanout.output[idx].output->write(fanout.data);
+    }
+
+    fanout.length = 0;
+    fanout.line_started = !eol;
+}
+
+// Write string to all registered outputs, may be assigned to hal.stream.write_all.
+void stream_fanout_write_all (const char *s)
+{
+    char c;
+
+    while((c = *s++)) {
+
+        fanout.data[fanout.length++] = c;
+
+        if(c == ASCII_LF)
+            fanout_dispatch(true);
+        else if(fanout.length == STREAM_FANOUT_LINE_SIZE - 1) // Overlong line, dispatch what we have.
+            fanout_dispatch(false);
+    }
+}
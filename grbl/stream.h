@@ -103,4 +103,37 @@ typedef struct {
     char data[BLOCK_TX_BUFFER_SIZE];
 } stream_block_tx_buffer_t;
 
+// Output fan-out, may be used by drivers to implement hal.stream.write_all for several outputs.
+// Output is assembled into lines before it is dispatched, each output receives complete lines only.
+// Realtime reports ('<' lines) are dropped for outputs that do not have room for a full line in
+// their transmit buffer or when the report interval set for the output has not yet elapsed.
+// Other lines are always written to the active stream, for other outputs the drop policy applies.
+
+#ifndef STREAM_FANOUT_MAX_OUTPUTS
+#define STREAM_FANOUT_MAX_OUTPUTS 4
+#endif
+
+#ifndef STREAM_FANOUT_LINE_SIZE
+#define STREAM_FANOUT_LINE_SIZE 256
+#endif
+
+typedef enum {
+    FanoutDrop_Reports = 0, // drop realtime reports when output transmit buffer is full, block for other output
+    FanoutDrop_All          // drop any output when output transmit buffer is full
+} fanout_drop_policy_t;
+
+typedef struct {
+    stream_type_t type;
+    void (*write)(const char *s);
+    uint16_t (*get_tx_buffer_free)(void);   // optional, output is blocking if not provided
+    bool (*is_connected)(void);             // optional, output is always active if not provided
+    uint16_t report_interval;               // min. time between realtime reports in ms, 0 for no limit.
+                                            // Not used for the active stream. Requires hal.get_elapsed_ticks.
+    fanout_drop_policy_t drop_policy;       // not used for the active stream
+} stream_output_t;
+
+bool stream_fanout_register (const stream_output_t *output);
+void stream_fanout_write_all (const char *s);
+uint32_t stream_fanout_get_dropped (stream_type_t type);
+
 #endif
@@ -91,6 +91,35 @@ void system_execute_startup (char *line)
 }
 
 
+// Velocity mode jog command, $JV=<axis letter><rate>..., e.g. $JV=X1000Y-500.
+// Rates are in current units per minute, the sign gives the direction. Axes not specified are stopped.
+// Senders must repeat the setpoint within JOG_VELOCITY_TIMEOUT ms while jogging, all zero or $JV= stops the jog.
+static status_code_t jog_velocity (char *line)
+{
+    char letter;
+    float value, velocity[N_AXIS] = {0};
+    uint_fast8_t idx, char_counter = 0;
+
+    while((letter = line[char_counter]) != '\0') {
+
+        idx = N_AXIS;
+        do {
+            idx--;
+        } while(idx && letter != *axis_letter[idx]);
+
+        if(letter != *axis_letter[idx])
+            return Status_GcodeUnsupportedCommand;
+
+        char_counter++;
+        if(!read_float(line, &char_counter, &value))
+            return Status_BadNumberFormat;
+
+        velocity[idx] = gc_state.modal.units_imperial ? value * MM_PER_INCH : value;
+    }
+
+    return mc_jog_velocity(velocity);
+}
+
 // Directs and executes one line of formatted input from protocol_process. While mostly
 // incoming streaming g-code blocks, this also executes Grbl internal commands, such as
 // settings, initiating the homing cycle, and toggling switch states. This differs from
@@ -130,6 +159,8 @@ status_code_t system_execute_line (char *line)
         case 'J': // Jogging, execute only if in IDLE or JOG states.
             if (!(sys.state == STATE_IDLE || (sys.state & (STATE_JOG|STATE_TOOL_CHANGE))))
                 retval = Status_IdleError;
+            else if(line[2] == 'V' && line[3] == '=') // Velocity mode jogging, $JV=<axis letter><rate>...
+                retval = jog_velocity(&line[4]);
             else
                 retval = line[2] != '=' ? Status_InvalidStatement : gc_execute_block(line, NULL); // NOTE: $J= is ignored inside g-code parser and used to detect jog motions.
             break;
@@ -316,6 +347,88 @@ status_code_t system_execute_line (char *line)
                 retval = Status_InvalidStatement;
             break;
 
+#ifdef ENABLE_LASER_RASTER
+        case 'L': // Load laser raster line, $LR=<base64 encoded pixel power>
+            if(!(line[2] == 'R' && line[3] == '='))
+                retval = Status_InvalidStatement;
+            else if (!(sys.state == STATE_IDLE || (sys.state & (STATE_CYCLE|STATE_HOLD|STATE_CHECK_MODE))))
+                retval = Status_IdleError;
+            else
+                retval = gc_load_raster_line(&lcline[4]); // Case sensitive data
+            break;
+#endif
+
+#if defined(KINEMATICS_API) && defined(KINEMATICS_VERIFY)
+        case 'K': // Kinematics round-trip verification, $KV=<number of targets> [IDLE/ALARM]
+            if(!(line[2] == 'V' && line[3] == '='))
+                retval = Status_InvalidStatement;
+            else if (!(sys.state == STATE_IDLE || (sys.state & (STATE_ALARM|STATE_ESTOP))))
+                retval = Status_IdleError;
+            else {
+                float n_targets;
+                uint_fast8_t counter = 4;
+                if(!read_float(line, &counter, &n_targets) || line[counter] != '\0')
+                    retval = Status_BadNumberFormat;
+                else if(!isintf(n_targets) || n_targets < 1.0f)
+                    retval = Status_InvalidStatement;
+                else
+                    kinematics_verify((uint32_t)n_targets);
+            }
+            break;
+#endif
+
+#ifdef ENABLE_PROBE_GRID
+        case 'P': // Multi-point probing
+            if(!(hal.probe_get_state && line[2] == 'R' && line[3] == 'B' && line[4] == 'G'))
+                retval = Status_InvalidStatement;
+            else if(line[5] == '\0') { // Print results [IDLE/ALARM]
+                if (!(sys.state == STATE_IDLE || (sys.state & (STATE_ALARM|STATE_ESTOP|STATE_CHECK_MODE))))
+                    retval = Status_IdleError;
+                else
+                    report_probe_table();
+            } else if(line[5] == '=') { // $PRBG=<x>,<y>,<x spacing>,<y spacing>,<x points>,<y points>,<clearance z>,<probe z>,<feed rate> [IDLE]
+                if (!(sys.state == STATE_IDLE || sys.state == STATE_CHECK_MODE))
+                    retval = Status_IdleError;
+                else {
+                    float value[9];
+                    uint_fast8_t idx = 0, counter = 6;
+                    probe_grid_t grid;
+
+                    do {
+                        if(!read_float(line, &counter, &value[idx]))
+                            retval = Status_BadNumberFormat;
+                        else if(line[counter] != (idx == 8 ? '\0' : ','))
+                            retval = Status_InvalidStatement;
+                        counter++;
+                    } while(retval == Status_OK && ++idx < 9);
+
+                    if(retval == Status_OK) {
+                        if(!(isintf(value[4]) && isintf(value[5]) && value[4] >= 1.0f && value[5] >= 1.0f &&
+                              value[4] * value[5] <= (float)PROBE_GRID_MAX_POINTS))
+                            retval = Status_InvalidStatement;
+                        else if(value[2] < 0.0f || value[3] < 0.0f || value[8] <= 0.0f)
+                            retval = Status_NegativeValue;
+                        else if(value[7] >= value[6])
+                            retval = Status_InvalidStatement;
+                        else {
+                            grid.origin[X_AXIS] = value[0];
+                            grid.origin[Y_AXIS] = value[1];
+                            grid.spacing[X_AXIS] = value[2];
+                            grid.spacing[Y_AXIS] = value[3];
+                            grid.points[X_AXIS] = (uint16_t)value[4];
+                            grid.points[Y_AXIS] = (uint16_t)value[5];
+                            grid.clearance = value[6];
+                            grid.depth = value[7];
+                            grid.feed_rate = value[8];
+                            retval = mc_probe_grid(&grid);
+                        }
+                    }
+                }
+            } else
+                retval = Status_InvalidStatement;
+            break;
+#endif
+
         case '#': // Print Grbl NGC parameters
             if (line[2] != '\0')
                 retval = Status_InvalidStatement;
@@ -163,18 +163,6 @@ typedef union {
     };
 } spindle_stop_t;
 
-#ifdef PID_LOG
-
-typedef struct {
-    uint_fast16_t idx;
-    float setpoint;
-    float t_sample;
-    float target[PID_LOG];
-    float actual[PID_LOG];
-} pid_data_t;
-
-#endif
-
 typedef union {
     uint16_t value;
     struct {
@@ -235,6 +223,7 @@ typedef struct {
     step_control_t step_control;        // Governs the step segment generator depending on system state.
     axes_signals_t homing_axis_lock;    // Locks axes when limits engage. Used as an axis motion mask in the stepper ISR.
     axes_signals_t homing;              // Axes with homing enabled.
+    axes_signals_t homing_sensorless;   // Axes with sensorless limit inputs (stall detection), set by driver/plugin when homing is enabled.
     axes_signals_t homed;               // Indicates which axes has been homed.
     overrides_t override;               // Override values & states
     report_tracking_flags_t report;     // Tracks when to add data to status reports.
@@ -243,9 +232,6 @@ typedef struct {
     float home_position[N_AXIS];        // Home position for homed axes
     float spindle_rpm;
     char *message;                      // Message to be displayed
-#ifdef PID_LOG
-    pid_data_t pid_log;
-#endif
 } system_t;
 
 extern system_t sys;
@@ -28,13 +28,15 @@
 
 #ifdef WALL_PLOTTER
 
+#include <math.h>
+#include <string.h>
+
 #include "settings.h"
 #include "planner.h"
 #include "kinematics.h"
 
 #define A_MOTOR X_AXIS // Must be X_AXIS
 #define B_MOTOR Y_AXIS // Must be Y_AXIS
-#define MAX_SEG_LENGTH_MM 2.0f
 
 typedef struct {
     int32_t width;
@@ -96,59 +98,15 @@ static void wp_plan_target_to_steps (int32_t *target_steps, float *target)
     target_steps[B_MOTOR] = wp_convert_to_b_motor_steps(target);
 }
 
-// Wall plotter is circular in motion, so long lines must be divided up
-static bool wp_segment_line (float *target, plan_line_data_t *pl_data, bool init)
+// Transform cartesian position to motor (string) lengths in mm, used for adaptive line segmentation
+static void wp_transform_from_cartesian (float *target, float *position)
 {
-    static uint_fast16_t iterations;
-    static bool segmented;
-    static float delta[N_AXIS], segment_target[N_AXIS];
-//    static plan_line_data_t plan;
-
-    uint_fast8_t idx = N_AXIS;
-
-    if(init) {
-
-        float max_delta = 0.0f;
-
-        do {
-            idx--;
-            delta[idx] = target[idx] - gc_state.position[idx];
-            max_delta = max(max_delta, fabsf(delta[idx]));
-        } while(idx);
-
-        if((segmented = !(pl_data->condition.rapid_motion || pl_data->condition.jog_motion) &&
-                           max_delta > MAX_SEG_LENGTH_MM && !(delta[X_AXIS] == 0.0f && delta[Y_AXIS] == 0.0f))) {
-
-            idx = N_AXIS;
-            iterations = (uint_fast16_t)ceilf(max_delta / MAX_SEG_LENGTH_MM);
+    float xpos = machine.width_mm - position[A_MOTOR];
 
-            memcpy(segment_target, gc_state.position, sizeof(segment_target));
-//            memcpy(&plan, pl_data, sizeof(plan_line_data_t));
-
-            do {
-                delta[--idx] /= (float)iterations;
-                target[idx] = gc_state.position[idx];
-            } while(idx);
-
-        } else
-            iterations = 1;
-
-        iterations++; // return at least one iteration
-
-    } else {
-
-        iterations--;
-
-        if(segmented && iterations) do {
-            idx--;
-            segment_target[idx] += delta[idx];
-            target[idx] = segment_target[idx];
-//            memcpy(pl_data, &plan, sizeof(plan_line_data_t));
-        } while(idx);
-
-    }
+    memcpy(target, position, sizeof(float) * N_AXIS);
 
-    return iterations != 0;
+    target[A_MOTOR] = sqrtf(position[A_MOTOR] * position[A_MOTOR] + position[B_MOTOR] * position[B_MOTOR]);
+    target[B_MOTOR] = sqrtf(xpos * xpos + position[B_MOTOR] * position[B_MOTOR]);
 }
 
 
@@ -255,7 +213,8 @@ void wall_plotter_init (void)
     kinematics.limits_set_machine_positions = wp_limits_set_machine_positions;
     kinematics.plan_target_to_steps = wp_plan_target_to_steps;
     kinematics.convert_array_steps_to_mpos = wp_convert_array_steps_to_mpos;
-    kinematics.segment_line = wp_segment_line;
+    kinematics.transform_from_cartesian = wp_transform_from_cartesian;
+    kinematics.segment_line = kinematics_adaptive_segment_line; // Wall plotter is circular in motion, so long lines must be divided up
 }
 
 #endif
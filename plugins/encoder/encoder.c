@@ -29,9 +29,13 @@
 #ifdef ARDUINO
 #include "../grbl/grbl.h"
 #include "../grbl/report.h"
+#include "../grbl/override.h"
+#include "../grbl/motion_control.h"
 #else
 #include "grbl/grbl.h"
 #include "grbl/report.h"
+#include "grbl/override.h"
+#include "grbl/motion_control.h"
 #endif
 
 #include "../uart.h"
@@ -80,9 +84,17 @@ typedef struct {
     mpg_algo_ptr handler;
 } mpg_t;
 
+typedef struct {
+    uint8_t base;   // Override value at latch
+    uint8_t value;  // Last override value set by the encoder
+    uint8_t seen;   // Override value seen at last encoder event
+    int32_t count;  // Encoder count at latch
+} override_track_t;
+
 static bool mode_chg = false;
 static char gcode[50];
 static int32_t npos[N_ENCODER] = {0};
+static override_track_t override_track[N_ENCODER] = {0};
 static mpg_t mpg[N_AXIS] = {0};
 static mpg_event_t mpg_events[N_AXIS] = {0};
 static encoder_t *override_encoder = NULL; // NULL when no Encoder_Universal available
@@ -147,6 +159,8 @@ serialWriteS(ASCII_EOL);
     return is_moving;
 }
 
+// Jogs are queued directly via the motion control jog API, no g-code is generated.
+// Encoder movement is accumulated and added to the next jog if the jog is not accepted.
 static bool mpg_jog_relative (uint_fast16_t state, axes_signals_t axes)
 {
     static bool is_moving = false;
@@ -154,20 +168,16 @@ static bool mpg_jog_relative (uint_fast16_t state, axes_signals_t axes)
     int32_t delta;
     uint32_t velocity = 0;
     uint_fast8_t idx = 0;
-
-    strcpy(gcode, "$J=G91");
-
-//   serialWriteS(uitoa(mpg[idx].encoder->position));
-//   serialWriteS(ASCII_EOL);
+    axes_signals_t moved = {0};
+    float distance[N_AXIS] = {0};
 
     while(axes.mask) {
 
         if(axes.mask & 0x01) {
             if((delta = mpg[idx].position - npos[mpg[idx].encoder->id]) != 0) {
-                float pos_delta = (float)delta * mpg[idx].scale_factor / 100.0f;
-                mpg[idx].position = npos[idx];
+                moved.mask |= bit(idx);
+                distance[idx] = (float)delta * mpg[idx].scale_factor / 100.0f;
                 velocity = velocity == 0 ? mpg[idx].encoder->velocity : MIN(mpg[idx].encoder->velocity, velocity);
-                sprintf(append(gcode), "%s%.3f", axis_letter[idx], pos_delta);
             }
         }
 
@@ -175,22 +185,19 @@ static bool mpg_jog_relative (uint_fast16_t state, axes_signals_t axes)
         axes.mask >>= 1;
     }
 
-    if(strlen(gcode) > 6 && velocity > 0) {
-
-        sprintf(append(gcode), "F%lu", velocity);
+    if(moved.mask && velocity > 0) {
 
-        is_moving = grbl.protocol_enqueue_gcode(gcode);
+        if((is_moving = mc_jog_relative(distance, (float)velocity) == Status_OK)) {
+            for(idx = 0; idx < N_AXIS; idx++) {
+                if(moved.mask & bit(idx))
+                    mpg[idx].position = npos[mpg[idx].encoder->id];
+            }
+        }
 
 #ifdef UART_DEBUG
-serialWriteS(gcode);
-serialWriteS(" ");
 serialWriteS(uitoa(is_moving));
 serialWriteS(ASCII_EOL);
 #endif
-/*
-serialWriteS(itoa(npos[mpg[idx].encoder->id], gcode, 10));
-serialWriteS(ASCII_EOL);
-*/
     }
 
     return is_moving;
@@ -198,6 +205,22 @@ serialWriteS(ASCII_EOL);
 
 // End MPG encoder movement algorithms
 
+// Returns new override value for the encoder count. The override is changed relative to its current value,
+// latched when the encoder mode is entered or when the override has been changed from elsewhere.
+static uint8_t override_value (encoder_t *encoder, uint8_t current, int32_t n_count, int32_t increment, int32_t min_value, int32_t max_value)
+{
+    override_track_t *ovr = &override_track[encoder->id];
+
+    if(current != ovr->seen && current != ovr->value) {
+        ovr->base = current;
+        ovr->count = npos[encoder->id];
+    }
+
+    ovr->seen = current;
+
+    return ovr->value = (uint8_t)max(min((int32_t)ovr->base + (n_count - ovr->count) * increment, max_value), min_value);
+}
+
 static inline void reset_override (encoder_mode_t mode)
 {
     switch(mode) {
@@ -340,6 +363,11 @@ void encoder_event (encoder_t *encoder, int32_t position)
             sys.report.encoder = On;
             encoder->event.click = Off;
             encoder->mode = encoder->mode == Encoder_FeedRate ? Encoder_RapidRate : (encoder->mode == Encoder_RapidRate ? Encoder_Spindle_RPM : Encoder_FeedRate);
+            // Start counting from zero in the new mode, the override value is latched on the next event.
+            npos[encoder->id] = encoder->position = 0;
+            override_track[encoder->id].seen = override_track[encoder->id].value = 0;
+            encoder->event.events = 0;
+            hal.encoder_reset(encoder->id);
         } else if(encoder->settings->mode == Encoder_MPG) {
             if(++encoder->axis == N_AXIS)
                 encoder->axis = X_AXIS;
@@ -364,15 +392,11 @@ void encoder_event (encoder_t *encoder, int32_t position)
 
         if(n_count != npos[encoder->id] || encoder->velocity == 0) switch(encoder->mode) {
 
+            // Encoder count changes the override value relative to the value when latched,
+            // the encoder is reset along with the override on events.
             case Encoder_FeedRate:
                 update_position = true;
-                if(n_count < npos[encoder->id]) {
-                    while(npos[encoder->id]-- != n_count)
-                        hal.stream.enqueue_realtime_command(CMD_OVERRIDE_FEED_FINE_MINUS);
-                } else {
-                    while(npos[encoder->id]++ != n_count)
-                        hal.stream.enqueue_realtime_command(CMD_OVERRIDE_FEED_FINE_PLUS);
-                }
+                set_feed_override_value(override_value(encoder, sys.override.feed_rate, n_count, FEED_OVERRIDE_FINE_INCREMENT, MIN_FEED_RATE_OVERRIDE, MAX_FEED_RATE_OVERRIDE));
                 break;
 
             case Encoder_RapidRate:
@@ -404,13 +428,7 @@ void encoder_event (encoder_t *encoder, int32_t position)
 
             case Encoder_Spindle_RPM:
                 update_position = true;
-                if(n_count < npos[encoder->id]) {
-                    while(npos[encoder->id]-- != n_count)
-                        hal.stream.enqueue_realtime_command(CMD_OVERRIDE_SPINDLE_FINE_MINUS);
-                } else {
-                    while(npos[encoder->id]++ != n_count)
-                        hal.stream.enqueue_realtime_command(CMD_OVERRIDE_SPINDLE_FINE_PLUS);
-                }
+                set_spindle_override_value(override_value(encoder, sys.override.spindle_rpm, n_count, SPINDLE_OVERRIDE_FINE_INCREMENT, MIN_SPINDLE_RPM_OVERRIDE, MAX_SPINDLE_RPM_OVERRIDE));
                 break;
 
             case Encoder_MPG:
@@ -455,6 +473,7 @@ void encoder_event (encoder_t *encoder, int32_t position)
         case Encoder_RapidRate:
         case Encoder_Spindle_RPM:
             npos[encoder->id] = encoder->position = 0;
+            override_track[encoder->id].seen = override_track[encoder->id].value = 0;
             hal.encoder_reset(encoder->id);
             reset_override(encoder->mode);
             break;
@@ -0,0 +1,216 @@
+//
+// StreamCredit.c - windowed "ok" batching for network streams
+//
+// v1.0 / 2020-09-28 / Io Engineering / Terje
+//
+
+/*
+
+Copyright (c) 2020, Terje Io
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+ Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+ Neither the name of the copyright holder nor the names of its contributors may
+be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+//
+// Opt-in streaming mode for network senders, enabled per connection with $OKBATCH=<n>.
+//
+// When enabled successful lines are no longer acknowledged one by one, instead the
+// acknowledgements are coalesced into a single response:
+//
+//   ok:<lines>|Bf:<planner blocks available>,<rx buffer bytes available>
+//
+// A batch is sent when <n> lines has been executed, when the input buffer runs dry or
+// when the oldest pending acknowledge is STREAM_CREDIT_LATENCY ms old. Any other response
+// (error:, ALARM: etc.) is always preceded by the pending batch so ordering is kept.
+//
+// The mode is cleared on reset and when the network connection is closed.
+// $OKBATCH=0 disables it, $OKBATCH reports the current window size.
+//
+
+#include "networking.h"
+
+#if TELNET_ENABLE || WEBSOCKET_ENABLE
+
+#include <string.h>
+
+#include "StreamCredit.h"
+
+#include "grbl/grbl.h"
+#include "grbl/planner.h"
+
+typedef struct {
+    stream_type_t stream;   // stream the mode was enabled for
+    uint_fast8_t window;    // max lines per acknowledge, 0 = disabled
+    uint_fast8_t pending;   // lines executed but not yet acknowledged
+    uint32_t ms;            // timestamp of oldest pending acknowledge
+    status_code_t (*status_message)(status_code_t status_code);
+} stream_credit_t;
+
+static stream_credit_t credit = {0};
+static driver_reset_ptr driver_reset = NULL;
+static on_execute_realtime_ptr on_execute_realtime = NULL;
+static status_code_t (*on_unknown_sys_command)(uint_fast16_t state, char *line, char *lcline) = NULL;
+
+static inline bool is_active (void)
+{
+    return credit.window && hal.stream.type == credit.stream;
+}
+
+static inline bool rx_is_empty (void)
+{
+    return hal.stream.get_rx_buffer_available() >= RX_BUFFER_SIZE - 1;
+}
+
+// Send pending acknowledge, if any, along with the current credit window.
+void StreamCreditFlush (void)
+{
+    uint_fast8_t lines = credit.pending;
+
+    credit.pending = 0;
+
+    if(lines && hal.stream.type == credit.stream) {
+        hal.stream.write("ok:");
+        hal.stream.write(uitoa((uint32_t)lines));
+        hal.stream.write("|Bf:");
+        hal.stream.write(uitoa((uint32_t)plan_get_block_buffer_available()));
+        hal.stream.write(",");
+        hal.stream.write(uitoa(hal.stream.get_rx_buffer_available()));
+        hal.stream.write(ASCII_EOL);
+    }
+}
+
+static status_code_t streamStatusMessage (status_code_t status_code)
+{
+    if(status_code == Status_OK && is_active()) {
+
+        if(credit.pending++ == 0 && hal.get_elapsed_ticks)
+            credit.ms = hal.get_elapsed_ticks();
+
+        if(credit.pending >= credit.window || rx_is_empty())
+            StreamCreditFlush();
+
+        return status_code;
+    }
+
+    // Keep response order: pending acknowledges first.
+    StreamCreditFlush();
+
+    return credit.status_message(status_code);
+}
+
+static void streamCreditDisable (void)
+{
+    credit.window = credit.pending = 0;
+
+    if(grbl.report.status_message == streamStatusMessage)
+        grbl.report.status_message = credit.status_message;
+}
+
+static void streamCreditPoll (uint_fast16_t state)
+{
+    if(credit.window) {
+
+        // Report entry points are restored by the core on reset, and a new
+        // connection has to opt in again.
+        if(grbl.report.status_message != streamStatusMessage || hal.stream.type != credit.stream)
+            streamCreditDisable();
+
+        else if(credit.pending && (rx_is_empty() || (hal.get_elapsed_ticks && (hal.get_elapsed_ticks() - credit.ms) >= STREAM_CREDIT_LATENCY)))
+            StreamCreditFlush();
+    }
+
+    on_execute_realtime(state);
+}
+
+static void streamCreditReset (void)
+{
+    // Acknowledge lines already executed before the reset message is output.
+    if(is_active())
+        StreamCreditFlush();
+
+    driver_reset();
+}
+
+static status_code_t commandExecute (uint_fast16_t state, char *line, char *lcline)
+{
+    status_code_t retval = Status_Unhandled;
+
+    if(!strncmp(&line[1], "OKBATCH", 7) && (hal.stream.type == StreamType_Telnet || hal.stream.type == StreamType_WebSocket)) {
+
+        if(line[8] == '\0') {
+            hal.stream.write("[OKBATCH:");
+            hal.stream.write(uitoa((uint32_t)(is_active() ? credit.window : 0)));
+            hal.stream.write(",");
+            hal.stream.write(uitoa(STREAM_CREDIT_LATENCY));
+            hal.stream.write("]" ASCII_EOL);
+            retval = Status_OK;
+        } else if(line[8] == '=') {
+
+            float window;
+            uint_fast8_t counter = 9;
+
+            if(!read_float(line, &counter, &window) || line[counter] != '\0')
+                retval = Status_BadNumberFormat;
+            else if(window < 0.0f || window > (float)STREAM_CREDIT_MAX_WINDOW || !isintf(window))
+                retval = Status_InvalidStatement;
+            else if(window == 0.0f) {
+                StreamCreditFlush();
+                streamCreditDisable();
+                retval = Status_OK;
+            } else {
+                StreamCreditFlush();
+                credit.stream = hal.stream.type;
+                credit.window = (uint_fast8_t)window;
+                if(grbl.report.status_message != streamStatusMessage) {
+                    credit.status_message = grbl.report.status_message;
+                    grbl.report.status_message = streamStatusMessage;
+                }
+                retval = Status_OK;
+            }
+        }
+    }
+
+    return retval == Status_Unhandled && on_unknown_sys_command ? on_unknown_sys_command(state, line, lcline) : retval;
+}
+
+void StreamCreditInit (void)
+{
+    if(driver_reset == NULL) {
+
+        driver_reset = hal.driver_reset;
+        hal.driver_reset = streamCreditReset;
+
+        on_execute_realtime = grbl.on_execute_realtime;
+        grbl.on_execute_realtime = streamCreditPoll;
+
+        on_unknown_sys_command = grbl.on_unknown_sys_command;
+        grbl.on_unknown_sys_command = commandExecute;
+    }
+}
+
+#endif
@@ -117,6 +117,8 @@ void TCPStreamInit (void)
     }
 
     streamSession.rcvTail = streamSession.rcvHead = &streamSession.queue[0];
+
+    StreamCreditInit();
 }
 
 //
@@ -222,6 +224,11 @@ uint16_t TCPStreamTxCount(void) {
     return BUFCOUNT(head, tail, TX_BUFFER_SIZE);
 }
 
+uint16_t TCPStreamTxFree (void)
+{
+    return (TX_BUFFER_SIZE - 1) - TCPStreamTxCount();
+}
+
 static int16_t streamReadTXC (void)
 {
     int16_t data;
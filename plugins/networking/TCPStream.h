@@ -50,6 +50,7 @@ void TCPStreamWriteS(const char *data);
 void TCPStreamWriteLn(const char *data);
 void TCPStreamWrite(const char *data, unsigned int length);
 uint16_t TCPStreamTxCount(void);
+uint16_t TCPStreamTxFree(void);
 uint16_t TCPStreamRxCount(void);
 uint16_t TCPStreamRxFree(void);
 void TCPStreamRxFlush(void);
@@ -207,6 +207,8 @@ void WsStreamInit (void)
     }
 
     streamSession.rcvTail = streamSession.rcvHead = &streamSession.queue[0];
+
+    StreamCreditInit();
 }
 
 //
@@ -312,6 +314,11 @@ uint16_t WsStreamTxCount(void) {
     return BUFCOUNT(head, tail, TX_BUFFER_SIZE);
 }
 
+uint16_t WsStreamTxFree (void)
+{
+    return (TX_BUFFER_SIZE - 1) - WsStreamTxCount();
+}
+
 static int16_t streamReadTXC (void)
 {
     int16_t data;
@@ -50,6 +50,7 @@ void WsStreamWriteS(const char *data);
 void WsStreamWriteLn(const char *data);
 void WsStreamWrite(const char *data, unsigned int length);
 uint16_t WsStreamTxCount(void);
+uint16_t WsStreamTxFree(void);
 uint16_t WsStreamRxCount(void);
 uint16_t WsStreamRxFree(void);
 void WsStreamRxFlush(void);
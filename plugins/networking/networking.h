@@ -34,6 +34,10 @@
 #include "WsSTream.h"
 #endif
 
+#if TELNET_ENABLE || WEBSOCKET_ENABLE
+#include "StreamCredit.h"
+#endif
+
 //*****************************************************************************
 //
 // Ensure that AUTOIP COOP option is configured correctly.
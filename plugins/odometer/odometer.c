@@ -42,54 +42,59 @@
 
 static nvs_io_t *nvs = NULL;
 static bool odometer_changed = false;
-static uint32_t odometers_address;
+static uint32_t odometers_address, saved_ms = 0;
 static odometer_data_t odometers;
-static void (*stepper_pulse_start)(stepper_t *stepper);
+static void (*on_segment_prepared)(uint32_t *steps);
+static on_execute_realtime_ptr on_execute_realtime;
 static status_code_t (*on_unknown_sys_command)(uint_fast16_t state, char *line, char *lcline);
 void (*on_state_change)(uint_fast16_t state);
 
-static void stepperPulseStart (stepper_t *stepper)
+// Steps are accumulated per segment by the foreground process, no overhead in the stepper ISR.
+static void onSegmentPrepared (uint32_t *steps)
 {
-    odometer_changed = true;
-
-    if(stepper->step_outbits.x)
-        odometers.distance[X_AXIS]++;
+    uint_fast8_t idx = N_AXIS;
 
-    if(stepper->step_outbits.y)
-        odometers.distance[Y_AXIS]++;
+    odometer_changed = true;
 
-    if(stepper->step_outbits.z)
-        odometers.distance[Z_AXIS]++;
+    do {
+        idx--;
+        odometers.distance[idx] += steps[idx];
+    } while(idx);
 
-#ifdef A_AXIS
-    if(stepper->step_outbits.a)
-        odometers.distance[A_AXIS]++;
-#endif
+    if(on_segment_prepared)
+        on_segment_prepared(steps);
+}
 
-#ifdef B_AXIS
-    if(stepper->step_outbits.b)
-        odometers.distance[B_AXIS]++;
-#endif
+static void odometer_save (void)
+{
+    odometer_changed = false;
+    saved_ms = hal.get_elapsed_ticks();
+    nvs->memcpy_to_with_checksum(odometers_address, (uint8_t *)&odometers, sizeof(odometer_data_t));
+}
 
-#ifdef C_AXIS
-    if(stepper->step_outbits.b)
-        odometers.distance[C_AXIS]++;
-#endif
+// Write changes to non-volatile storage when idle, at most once every ODOMETER_SAVE_INTERVAL ms.
+static void odometerPoll (uint_fast16_t state)
+{
+    if(odometer_changed && state == STATE_IDLE && (hal.get_elapsed_ticks() - saved_ms) >= ODOMETER_SAVE_INTERVAL)
+        odometer_save();
 
-    stepper_pulse_start(stepper);
+    on_execute_realtime(state);
 }
 
 void onStateChanged (uint_fast16_t state)
 {
     static uint32_t ms = 0;
+    static bool running = false;
 
-    if(state & (STATE_CYCLE|STATE_JOG|STATE_HOMING))
-        ms = hal.get_elapsed_ticks();
-
-    else if(odometer_changed) {
-        odometer_changed = false;
+    if(state & (STATE_CYCLE|STATE_JOG|STATE_HOMING)) {
+        if(!running) {
+            running = true;
+            ms = hal.get_elapsed_ticks();
+        }
+    } else if(running) {
+        running = false;
+        odometer_changed = true;
         odometers.time += (hal.get_elapsed_ticks() - ms);
-        nvs->memcpy_to_with_checksum(odometers_address, (uint8_t *)&odometers, sizeof(odometer_data_t));
     }
 
     if(on_state_change)
@@ -100,7 +105,7 @@ static void odometer_data_reset (void)
 {
     // TODO: Write backup to second copy before reset
     memset(&odometers, 0, sizeof(odometer_data_t));
-    nvs->memcpy_to_with_checksum(odometers_address, (uint8_t *)&odometers, sizeof(odometer_data_t));
+    odometer_save();
 }
 
 static status_code_t commandExecute (uint_fast16_t state, char *line, char *lcline)
@@ -147,9 +152,6 @@ void odometer_init()
 
     else {
 
-        stepper_pulse_start = hal.stepper_pulse_start;
-        hal.stepper_pulse_start = stepperPulseStart;
-
         if(!init_ok) {
 
             init_ok = true;
@@ -163,6 +165,12 @@ void odometer_init()
 
             on_state_change = grbl.on_state_change;
             grbl.on_state_change = onStateChanged;
+
+            on_segment_prepared = grbl.on_segment_prepared;
+            grbl.on_segment_prepared = onSegmentPrepared;
+
+            on_execute_realtime = grbl.on_execute_realtime;
+            grbl.on_execute_realtime = odometerPoll;
         }
     }
 }
@@ -31,6 +31,11 @@ typedef struct {
     uint64_t distance[N_AXIS];
 } odometer_data_t;
 
+// Min time (in ms) between writes to non-volatile storage, changes are written when idle.
+#ifndef ODOMETER_SAVE_INTERVAL
+#define ODOMETER_SAVE_INTERVAL 60000
+#endif
+
 void odometer_init();
 
 #endif
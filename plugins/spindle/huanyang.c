@@ -58,13 +58,20 @@ static spindle_state_t vfd_state = {0};
 static uint32_t rpm_max = 0;
 #endif
 
+// Called from modbus_poll() context when a spindle command fails, raise alarm in the foreground.
+static void rx_async_exception (uint8_t code, void *context)
+{
+    system_set_exec_alarm(Alarm_Spindle);
+}
+
 static void spindleSetRPM (float rpm, bool block)
 {
-    modbus_message_t rpm_cmd;
+    modbus_message_t rpm_cmd = {0};
 
     if (rpm != rpm_programmed) {
 
-        rpm_cmd.xx = VFD_SetRPM;
+        rpm_cmd.xx = (void *)VFD_SetRPM;
+        rpm_cmd.on_rx_exception = rx_async_exception;
         rpm_cmd.adu[0] = VFD_ADDRESS;
 
 #if SPINDLE_HUANYANG == 2
@@ -112,9 +119,10 @@ static void spindleUpdateRPM (float rpm)
 // Start or stop spindle
 static void spindleSetState (spindle_state_t state, float rpm)
 {
-    modbus_message_t mode_cmd;
+    modbus_message_t mode_cmd = {0};
 
-    mode_cmd.xx = VFD_SetStatus;
+    mode_cmd.xx = (void *)VFD_SetStatus;
+    mode_cmd.on_rx_exception = rx_async_exception;
     mode_cmd.adu[0] = VFD_ADDRESS;
 
 #if SPINDLE_HUANYANG == 2
@@ -138,16 +146,17 @@ static void spindleSetState (spindle_state_t state, float rpm)
 
 #endif
 
+    // Wait for the VFD to confirm start/stop, RPM updates are queued and executed in order.
     if(modbus_send(&mode_cmd, true))
-        spindleSetRPM(rpm, true);
+        spindleSetRPM(rpm, false);
 }
 
 // Returns spindle state in a spindle_state_t variable
 static spindle_state_t spindleGetState (void)
 {
-    modbus_message_t mode_cmd;
+    modbus_message_t mode_cmd = {0};
 
-    mode_cmd.xx = VFD_GetRPM;
+    mode_cmd.xx = (void *)VFD_GetRPM;
     mode_cmd.adu[0] = VFD_ADDRESS;
 
 #if SPINDLE_HUANYANG == 2
@@ -174,7 +183,7 @@ static spindle_state_t spindleGetState (void)
 
 #endif
 
-    modbus_send(&mode_cmd, false);
+    modbus_send(&mode_cmd, false); // a poll still pending in the queue is superseded by this one
 
     return vfd_state; // return previous state as we do not want to wait for the response
 }
@@ -226,9 +235,9 @@ void huanyang_init (modbus_stream_t *stream)
 
 #if SPINDLE_HUANYANG == 2
 
-    modbus_message_t cmd;
+    modbus_message_t cmd = {0};
 
-    cmd.xx = VFD_GetMaxRPM;
+    cmd.xx = (void *)VFD_GetMaxRPM;
     cmd.adu[0] = VFD_ADDRESS;
     cmd.adu[1] = ModBus_ReadHoldingRegisters;
     cmd.adu[2] = 0xB0;
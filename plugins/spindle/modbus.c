@@ -5,8 +5,6 @@
   Part of GrblHAL
 
   Copyright (c) 2020 Terje Io
-  except modbus_CRC16x which is Copyright (c) 2006 Christian Walter <wolti@sil.at>
-  Lifted from his FreeModbus Libary
 
   Grbl is free software: you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
@@ -42,45 +40,126 @@ typedef struct queue_entry {
 
 static modbus_stream_t *stream;
 static uint16_t rx_timeout = 0;
+static uint_fast8_t rx_count = 0;
 static int16_t exception_code = 0;
+static char rx_buf[MODBUS_MAX_ADU_SIZE];
 static driver_reset_ptr driver_reset = NULL;
 static queue_entry_t queue[MODBUS_QUEUE_LENGTH];
-static volatile bool spin_lock = false;
+static volatile bool spin_lock = false, queue_lock = false;
 static volatile queue_entry_t *tail, *head, *packet = NULL;
 static volatile modbus_state_t state = ModBus_Idle;
 
-// Compute the MODBUS RTU CRC
-static uint16_t modbus_CRC16x (char *buf, uint_fast16_t len)
+// CRC-16/MODBUS lookup table, reflected polynomial 0xA001
+static const uint16_t crc_table[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+// Compute the MODBUS RTU CRC, one table lookup per byte
+static uint16_t modbus_CRC16x (const char *buf, uint_fast16_t len)
 {
     uint16_t crc = 0xFFFF;
-    uint_fast8_t pos, i;
-
-    for (pos = 0; pos < len; pos++) {
-        crc ^= (uint16_t)buf[pos];          // XOR byte into least sig. byte of crc
-        for (i = 8; i != 0; i--) {          // Loop over each bit
-            if ((crc & 0x0001) != 0) {      // If the LSB is set
-                crc >>= 1;                  // Shift right and XOR 0xA001
-                crc ^= 0xA001;
-            } else                          // Else LSB is not set
-                crc >>= 1;                  // Just shift right
-        }
-    }
+
+    while(len--)
+        crc = (crc >> 8) ^ crc_table[(crc ^ (uint8_t)*buf++) & 0xFF];
 
     // Note, this number has low and high bytes swapped, so use it accordingly (or swap bytes)
     return crc;
 }
 
-static bool valid_crc (char *buf, uint_fast16_t len)
+static bool valid_crc (const char *buf, uint_fast16_t len)
 {
     uint16_t crc = modbus_CRC16x(buf, len - 2);
 
-    return buf[len - 1] == (crc >> 8) && buf[len - 2] == (crc & 0xFF);
+    return (uint8_t)buf[len - 1] == (crc >> 8) && (uint8_t)buf[len - 2] == (crc & 0xFF);
+}
+
+static void rx_packet (queue_entry_t *entry)
+{
+    if(entry->msg.on_rx_packet)
+        entry->msg.on_rx_packet(&entry->msg);
+    else if(stream->on_rx_packet)
+        stream->on_rx_packet(&entry->msg);
+}
+
+static void rx_exception (queue_entry_t *entry, uint8_t code)
+{
+    if(entry->msg.on_rx_exception)
+        entry->msg.on_rx_exception(code, entry->msg.xx);
+    else if(!entry->async && stream->on_rx_exception)
+        stream->on_rx_exception(code);
+}
+
+static void transmit (queue_entry_t *entry)
+{
+    state = ModBus_TX;
+    rx_count = 0;
+    rx_timeout = entry->msg.timeout ? entry->msg.timeout : stream->rx_timeout;
+
+    if(stream->set_direction)
+        stream->set_direction(true);
+
+    entry->sent = true;
+    stream->flush_rx_buffer();
+    stream->write(entry->msg.adu, entry->msg.tx_length);
+}
+
+// Non-blocking requests are completed here, blocking requests are completed by modbus_send().
+static void complete (modbus_state_t result)
+{
+    queue_entry_t *entry = (queue_entry_t *)packet;
+
+    if(entry->async) {
+
+        packet = NULL;
+        state = ModBus_Idle;
+
+        if(result == ModBus_GotReply)
+            rx_packet(entry);
+        else
+            rx_exception(entry, result == ModBus_Exception && exception_code != -1 ? (uint8_t)(exception_code & 0xFF) : 0);
+    } else
+        state = result;
 }
 
+// Queue a request. Non-blocking requests are sent in order from modbus_poll(), an unsent request
+// for the same context, address and function is superseded by the new one. This coalesces repeated
+// polls and keeps only the latest value for repeated writes.
 bool modbus_send (modbus_message_t *msg, bool block)
 {
     static queue_entry_t sync_msg = {0};
 
+    bool ok = false;
     uint_fast16_t crc = modbus_CRC16x(msg->adu, msg->tx_length - 2);
 
     msg->adu[msg->tx_length - 1] = crc >> 8;
@@ -97,20 +176,13 @@ bool modbus_send (modbus_message_t *msg, bool block)
                 return false;
         }
 
-        if(stream->set_direction)
-            stream->set_direction(true);
-
-        state = ModBus_TX;
-        rx_timeout = stream->rx_timeout;
-
         memcpy(&sync_msg.msg, msg, sizeof(modbus_message_t));
 
         sync_msg.async = false;
-        stream->flush_rx_buffer();
-        stream->write(sync_msg.msg.adu, sync_msg.msg.tx_length);
-
         packet = &sync_msg;
 
+        transmit(&sync_msg);
+
         while(poll) {
 
             if(ABORTED)
@@ -119,19 +191,19 @@ bool modbus_send (modbus_message_t *msg, bool block)
             else switch(state) {
 
                 case ModBus_Timeout:
-                    stream->on_rx_exception(0);
+                    rx_exception(&sync_msg, 0);
                     poll = false;
                     break;
 
                 case ModBus_Exception:
-                    stream->on_rx_exception(exception_code == -1 ? 0 : (uint8_t)(exception_code & 0xFF));
+                    rx_exception(&sync_msg, exception_code == -1 ? 0 : (uint8_t)(exception_code & 0xFF));
                     poll = false;
                     break;
 
                 case ModBus_GotReply:
-                    if(packet)
-                        stream->on_rx_packet(&((queue_entry_t *)packet)->msg);
-                    poll = block = false;
+                    rx_packet(&sync_msg);
+                    poll = false;
+                    ok = true;
                     break;
 
                 default:
@@ -139,18 +211,32 @@ bool modbus_send (modbus_message_t *msg, bool block)
             }
         }
 
+        packet = NULL;
         state = ModBus_Idle;
 
     } else if(packet != &sync_msg) {
-        if(head->next != tail) {
+
+        queue_lock = true; // Block modbus_poll() from dequeuing while the queue is searched.
+
+        queue_entry_t *entry = (queue_entry_t *)tail;
+
+        while(entry != head && !(entry->msg.xx == msg->xx && entry->msg.adu[0] == msg->adu[0] && entry->msg.adu[1] == msg->adu[1]))
+            entry = entry->next;
+
+        if(entry != head) {
+            memcpy(&entry->msg, msg, sizeof(modbus_message_t));
+            ok = true;
+        } else if((ok = head->next != tail)) {
             head->async = true;
             head->sent = false;
             memcpy((void *)&(head->msg), msg, sizeof(modbus_message_t));
             head = head->next;
         }
+
+        queue_lock = false;
     }
 
-    return !block;
+    return ok;
 }
 
 modbus_state_t modbus_get_state (void)
@@ -158,6 +244,7 @@ modbus_state_t modbus_get_state (void)
     return state;
 }
 
+// Called from a 1 ms interval timer.
 void modbus_poll (void)
 {
     spin_lock = true;
@@ -165,19 +252,10 @@ void modbus_poll (void)
     switch(state) {
 
         case ModBus_Idle:
-            if(tail != head && !packet) {
-
+            if(tail != head && !packet && !queue_lock) {
                 packet = tail;
                 tail = tail->next;
-                state = ModBus_TX;
-                rx_timeout = stream->rx_timeout;
-
-                if(stream->set_direction)
-                    stream->set_direction(true);
-
-                packet->sent = true;
-                stream->flush_rx_buffer();
-                stream->write(((queue_entry_t *)packet)->msg.adu, ((queue_entry_t *)packet)->msg.tx_length);
+                transmit((queue_entry_t *)packet);
             }
             break;
 
@@ -192,32 +270,30 @@ void modbus_poll (void)
             break;
 
         case ModBus_AwaitReply:
-            if(rx_timeout && --rx_timeout == 0) {
-                if(packet->async)
-                    state = ModBus_Idle;
-                else if(stream->read() == 1 && (stream->read() & 0x80)) {
-                    exception_code = stream->read();
-                    state = ModBus_Exception;
-                } else
-                    state = ModBus_Timeout;
-                packet = NULL;
-                spin_lock = false;
-                return;
-            }
 
-            if(stream->get_rx_buffer_count() >= packet->msg.rx_length) {
+            // Collect the reply as it arrives, an exception reply is shorter than a normal reply.
+            while(rx_count < packet->msg.rx_length && stream->get_rx_buffer_count())
+                rx_buf[rx_count++] = (char)stream->read();
 
-                char *buf = ((queue_entry_t *)packet)->msg.adu;
-
-                do {
-                    *buf++ = stream->read();
-                } while(--packet->msg.rx_length);
-
-                if((state = packet->async ? ModBus_Idle : ModBus_GotReply) == ModBus_Idle)
-                    stream->on_rx_packet(&((queue_entry_t *)packet)->msg);
-
-                packet = NULL;
+            if(rx_count >= 2 && (rx_buf[1] & 0x80)) {
+                if(rx_count >= 5) {
+                    exception_code = valid_crc(rx_buf, 5) ? (uint8_t)rx_buf[2] : -1;
+                    complete(ModBus_Exception);
+                    break;
+                }
+            } else if(rx_count == packet->msg.rx_length) {
+                if(valid_crc(rx_buf, rx_count)) {
+                    memcpy(((queue_entry_t *)packet)->msg.adu, rx_buf, rx_count);
+                    complete(ModBus_GotReply);
+                } else {
+                    exception_code = -1;
+                    complete(ModBus_Exception);
+                }
+                break;
             }
+
+            if(rx_timeout && --rx_timeout == 0)
+                complete(ModBus_Timeout);
             break;
 
         default:
@@ -48,10 +48,15 @@ typedef enum {
     ModBus_Diagnostics = 8
 } modbus_function_t;
 
-typedef struct {
+typedef struct modbus_message {
     uint8_t tx_length;
     uint8_t rx_length;
-    void *xx;
+    uint16_t timeout;   // reply timeout in ms, stream default is used if 0
+    void *xx;           // context, passed back unchanged with the reply
+    // Optional per request callbacks, stream callbacks are used if NULL.
+    // NOTE: called from the modbus_poll() context for non-blocking requests!
+    void (*on_rx_packet)(struct modbus_message *msg);
+    void (*on_rx_exception)(uint8_t code, void *context);
     char adu[MODBUS_MAX_ADU_SIZE];
 } modbus_message_t;
 
@@ -64,7 +69,7 @@ typedef struct {
     int16_t (*read)(void);
     void (*flush_tx_buffer)(void);
     void (*flush_rx_buffer)(void);
-    // Callbacks
+    // Callbacks, exception callback is only called for blocking requests
     void (*on_rx_packet)(modbus_message_t *msg);
     void (*on_rx_exception)(uint8_t code);
 } modbus_stream_t;
@@ -50,7 +50,7 @@ static bool warning = false, is_homing = false;
 static volatile uint_fast16_t diag1_poll = 0;
 static char sbuf[65]; // string buffer for reports
 static TMC2130_t stepper[N_AXIS];
-static axes_signals_t homing = {0}, otpw_triggered = {0};
+static axes_signals_t homing = {0}, otpw_triggered = {0}, sg_primed = {0};
 static limits_get_state_ptr limits_get_state = NULL;
 static void (*hal_stepper_pulse_start)(stepper_t *stepper) = NULL;
 static void (*hal_execute_realtime)(uint_fast16_t state) = NULL;
@@ -632,6 +632,17 @@ axes_signals_t trinamic_stepper_enable (axes_signals_t enable)
 }
 #endif
 
+// Read a set of registers from a driver. SPI reads are pipelined, n registers takes n + 1 transfers instead of 2n.
+static void read_registers (TMC2130_t *driver, TMC2130_datagram_t **regs, uint_fast8_t n)
+{
+#if TRINAMIC_I2C
+    while(n--)
+        TMC2130_ReadRegister(driver, *regs++);
+#else
+    SPI_ReadRegisters(driver, regs, n);
+#endif
+}
+
 // hal.limits_get_state is redirected here when homing
 static axes_signals_t trinamic_limits (void)
 {
@@ -644,7 +655,18 @@ static axes_signals_t trinamic_limits (void)
         uint_fast8_t idx = N_AXIS;
         do {
             if(bit_istrue(homing.mask, bit(--idx))) {
+#if TRINAMIC_I2C
                 TMC2130_ReadRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].drv_status);
+#else
+                // Only DRV_STATUS is read while homing, after the first read a single transfer returns
+                // the status from the previous poll.
+                if(bit_istrue(sg_primed.mask, bit(idx)))
+                    SPI_PollRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].drv_status);
+                else {
+                    sg_primed.mask |= bit(idx);
+                    TMC2130_ReadRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].drv_status);
+                }
+#endif
                 if(stepper[idx].drv_status.reg.stallGuard)
                     bit_true(signals.mask, idx);
             }
@@ -663,6 +685,8 @@ void trinamic_homing (bool enable)
 
     is_homing = enable;
     enable = enable && homing.mask;
+    sg_primed.mask = 0;
+    sys.homing_sensorless.mask = enable ? homing.mask : 0; // Enables stall repeatability check in core homing
 
     do {
         if(bit_istrue(homing.mask, bit(--idx)))
@@ -691,10 +715,13 @@ static void write_debug_report (void)
 
     do {
         if(bit_istrue(report.axes.mask, bit(--idx))) {
-            TMC2130_ReadRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].chopconf);
-            TMC2130_ReadRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].drv_status);
-            TMC2130_ReadRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].pwm_scale);
-            TMC2130_ReadRegister(&stepper[idx], (TMC2130_datagram_t *)&stepper[idx].tstep);
+            TMC2130_datagram_t *regs[] = {
+                (TMC2130_datagram_t *)&stepper[idx].chopconf,
+                (TMC2130_datagram_t *)&stepper[idx].drv_status,
+                (TMC2130_datagram_t *)&stepper[idx].pwm_scale,
+                (TMC2130_datagram_t *)&stepper[idx].tstep
+            };
+            read_registers(&stepper[idx], regs, sizeof(regs) / sizeof(TMC2130_datagram_t *));
             if(stepper[idx].drv_status.reg.otpw)
                 otpw_triggered.mask |= bit(idx);
         }